@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "anybuf.hpp"
+#include "anybuf_rt.hpp"
+
+namespace
+{
+    /** shape of the generated schemas */
+    struct corpus
+    {
+        /** modules, spread over the files in order */
+        std::size_t modules = 64;
+        /** structs of each module */
+        std::size_t structs = 32;
+        /** bases of each struct, struct s3: s2, s1 */
+        std::size_t bases = 2;
+        /** members of each enum */
+        std::size_t width = 64;
+        /** files, each importing the one before */
+        std::size_t chain = 16;
+        /** depth of the nested tuple and map member */
+        std::size_t nesting = 4;
+    };
+
+    std::string nested(std::size_t depth)
+    {
+        if (depth == 0)
+            return "i32";
+        return depth % 2 ? "[" + nested(depth - 1) + ", e]" : "<str, " + nested(depth - 1) + ">[]";
+    }
+    /** write the schemas into the directory */
+    std::size_t generate(const corpus &corpus, const std::filesystem::path &directory)
+    {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        std::size_t bytes = 0;
+        auto chain = std::max<std::size_t>(corpus.chain, 1);
+        for (std::size_t file = 0, module = 0; file < chain; ++file)
+        {
+            std::string text;
+            if (file > 0)
+                text += "import \"f" + std::to_string(file - 1) + ".anybuf\";\n\n";
+
+            // module k is in a file at or after module k - 1, which it refers to
+            for (; module < corpus.modules && module * chain / corpus.modules == file; ++module)
+            {
+                auto name = "m" + std::to_string(module);
+                text += "/** module " + name + " */\nmodule " + name + " {\n";
+                text += "    enum e: " + std::string(corpus.width > 127 ? "i32" : "i8") + " {\n";
+                for (std::size_t i = 0; i < corpus.width; ++i)
+                    text += "        v" + std::to_string(i) + ",\n";
+                text += "    }\n";
+
+                for (std::size_t i = 0; i < corpus.structs; ++i)
+                {
+                    text += "    /** struct " + std::to_string(i) + " */\n    struct s" + std::to_string(i);
+                    for (std::size_t base = 1; base <= corpus.bases && base <= i; ++base)
+                        text += (base == 1 ? ": s" : ", s") + std::to_string(i - base);
+                    text += " {\n";
+                    text += "        a:0 i32;\n";
+                    text += "        b:1 str;\n";
+                    text += "        c:2 e;\n";
+                    if (module > 0)
+                        text += "        d?:3 m" + std::to_string(module - 1) + ".s" + std::to_string(i) + "[];\n";
+                    text += "        n:4 " + nested(corpus.nesting) + ";\n";
+                    text += "    }\n";
+                }
+                text += "}\n\n";
+            }
+
+            std::ofstream(directory / ("f" + std::to_string(file) + ".anybuf"), std::ios::binary) << text;
+            bytes += text.size();
+        }
+        return bytes;
+    }
+
+    std::size_t declarations(const std::vector<anybuf::content_node *> &nodes)
+    {
+        std::size_t count = 0;
+        auto walk = [&](anybuf::node *node, auto &walk) -> void {
+            ++count;
+            anybuf::visit(node, anybuf::overloaded{
+                                    [&](anybuf::emodule_node *node) {
+                                        for (auto member : node->members)
+                                            walk(member, walk);
+                                    },
+                                    [&](anybuf::eenum_node *node) {
+                                        for (auto member : node->members)
+                                            walk(member, walk);
+                                    },
+                                    [&](anybuf::estruct_node *node) {
+                                        for (auto member : node->members)
+                                            walk(member, walk);
+                                    },
+                                    [](anybuf::node *) {},
+                                });
+        };
+        for (auto node : nodes)
+            walk(node, walk);
+        return count;
+    }
+
+    /** best time of the runs in seconds, prepare isn't timed */
+    double measure(std::size_t runs, const std::function<void()> &prepare, const std::function<bool()> &run)
+    {
+        auto best = 0.0;
+        for (std::size_t i = 0; i < runs; ++i)
+        {
+            prepare();
+            auto start = std::chrono::steady_clock::now();
+            if (!run())
+                return -1;
+            std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+            if (i == 0 || time.count() < best)
+                best = time.count();
+        }
+        return best;
+    }
+    void report(const std::string &phase, double time, std::size_t tokens, std::size_t declarations)
+    {
+        if (time < 0)
+        {
+            std::printf("%-12s failed\n", phase.c_str());
+            return;
+        }
+        std::printf("%-12s %10.3f %16.0f %16.0f\n", phase.c_str(), time * 1000, tokens / time, declarations / time);
+    }
+
+    /** values of every kind the runtime encodes, as generated structs hold them */
+    using record = std::tuple<std::int32_t, std::uint64_t, double, bool, std::string, std::vector<std::uint16_t>, std::map<std::int32_t, float>>;
+    /** the record as the types generated in pmr mode hold it, the same bytes on the wire */
+    using pmr_record = std::tuple<std::int32_t, std::uint64_t, double, bool, std::pmr::string, std::pmr::vector<std::uint16_t>, std::pmr::map<std::int32_t, float>>;
+    std::vector<record> records(std::size_t count)
+    {
+        std::vector<record> records(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto &[a, b, c, d, e, f, g] = records[i];
+            a = static_cast<std::int32_t>(i) - 1000, b = i * 2654435761u, c = i * 0.5, d = i % 2 == 0;
+            e = "record " + std::to_string(i);
+            f.assign(i % 16, static_cast<std::uint16_t>(i));
+            for (std::size_t j = 0; j < i % 4; ++j)
+                g.emplace(static_cast<std::int32_t>(j), static_cast<float>(i + j));
+        }
+        return records;
+    }
+    void report_runtime(const std::string &phase, double time, std::size_t bytes)
+    {
+        if (time < 0)
+        {
+            std::printf("%-12s failed\n", phase.c_str());
+            return;
+        }
+        std::printf("%-12s %10.3f %16.1f\n", phase.c_str(), time * 1000, bytes / time / (1 << 20));
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    corpus corpus;
+    std::size_t runs = 5;
+    std::size_t record_count = 100000;
+    auto directory = std::filesystem::temp_directory_path() / "anybuf_bench";
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--out")
+        {
+            directory = argv[i + 1];
+            continue;
+        }
+
+        auto value = std::stoul(argv[i + 1]);
+        if (option == "--modules")
+            corpus.modules = value;
+        else if (option == "--structs")
+            corpus.structs = std::min<std::size_t>(value, 255);
+        else if (option == "--bases")
+            corpus.bases = value;
+        else if (option == "--width")
+            corpus.width = value;
+        else if (option == "--chain")
+            corpus.chain = value;
+        else if (option == "--nesting")
+            corpus.nesting = value;
+        else if (option == "--runs")
+            runs = std::max<std::size_t>(value, 1);
+        else if (option == "--records")
+            record_count = value;
+        else
+        {
+            std::cout << "usage: anybuf_bench [--modules n] [--structs n] [--bases n] [--width n] [--chain n] [--nesting n] [--runs n] [--records n] [--out dir]" << std::endl;
+            return 1;
+        }
+    }
+
+    auto bytes = generate(corpus, directory / "schema");
+
+    // one reader to count the tokens and the declarations and to be written
+    anybuf::reader reader;
+    reader.load((directory / "schema").string());
+    auto tokens = reader.scan();
+    if (!reader.read())
+    {
+        for (auto const &error : reader.errors())
+            std::cout << error << std::endl;
+        return 1;
+    }
+    auto count = declarations(reader.nodes());
+    std::printf("%zu files, %zu bytes, %zu tokens, %zu declarations, best of %zu runs\n\n",
+                reader.files().size(), bytes, tokens, count, runs);
+    std::printf("%-12s %10s %16s %16s\n", "phase", "ms", "tokens/s", "declarations/s");
+
+    // scan and read on the same reader, read then skips the scanned sources
+    std::unique_ptr<anybuf::reader> timed;
+    auto prepare = [&] {
+        timed = std::make_unique<anybuf::reader>();
+        timed->load((directory / "schema").string());
+    };
+    report("scan", measure(runs, prepare, [&] { return timed->scan() > 0; }), tokens, count);
+    report("read", measure(runs, [&] { prepare(), timed->scan(); }, [&] { return timed->read(); }), tokens, count);
+
+    // render alone, a commit after the first run finds the same bytes and skips the file
+    std::vector<anybuf::writer *> writers;
+    for (auto language : {"c", "cpp", "csharp", "java", "go", "rust", "ts", "python", "lua"})
+    {
+        auto writer = anybuf::writer::create(language, (directory / (std::string("out.") + language)).string());
+        report(std::string("write ") + language, measure(runs, [] {}, [&] { return writer->render(reader.nodes()); }), tokens, count);
+        writers.push_back(writer);
+    }
+    report("write all", measure(runs, [] {}, [&] { return anybuf::writer::write(writers, reader.nodes()); }), tokens, count);
+    for (auto writer : writers)
+        anybuf::writer::destroy(writer);
+
+    // the runtime alone, into a string that grows and into a buffer sized up front
+    auto values = records(record_count);
+    anybuf_rt::size_sink size;
+    anybuf_rt::put(size, values);
+    std::printf("\n%zu records, %zu bytes\n\n%-12s %10s %16s\n", record_count, size.size(), "runtime", "ms", "MB/s");
+
+    std::string encoded;
+    report_runtime("size", measure(runs, [] {}, [&] { anybuf_rt::size_sink sink; return anybuf_rt::put(sink, values), sink.size() == size.size(); }), size.size());
+    report_runtime("encode str", measure(runs, [&] { encoded = std::string(); }, [&] { return anybuf_rt::put(encoded, values), encoded.size() == size.size(); }), size.size());
+    std::vector<char> buffer(size.size());
+    report_runtime("encode buf", measure(runs, [] {}, [&] { anybuf_rt::buffer_sink sink(buffer.data()); return anybuf_rt::put(sink, values), sink.size() == size.size(); }), size.size());
+    std::vector<record> decoded;
+    report_runtime("decode", measure(runs, [&] { decoded.clear(); }, [&] { std::string_view in(encoded); return anybuf_rt::get(in, decoded) && in.size() == 0; }), size.size());
+
+    // every string, array and map of the records from one arena, released at once
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+    std::unique_ptr<std::pmr::vector<pmr_record>> arena_decoded;
+    auto reset = [&] {
+        arena_decoded.reset();
+        arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+        arena_decoded = std::make_unique<std::pmr::vector<pmr_record>>(arena.get());
+    };
+    report_runtime("decode pmr", measure(runs, reset, [&] { std::string_view in(encoded); return anybuf_rt::get(in, *arena_decoded) && in.size() == 0; }), size.size());
+
+    // numeric arrays, a block of the bytes on little endian hosts
+    std::vector<float> floats(record_count * 16);
+    for (std::size_t i = 0; i < floats.size(); ++i)
+        floats[i] = i * 0.25f;
+    std::string block;
+    std::vector<float> block_decoded;
+    auto block_size = floats.size() * sizeof(float);
+    report_runtime("encode f32[]", measure(runs, [&] { block = std::string(); }, [&] { return anybuf_rt::put(block, floats), block.size() > block_size; }), block_size);
+    report_runtime("decode f32[]", measure(runs, [&] { block_decoded = std::vector<float>(); }, [&] { std::string_view in(block); return anybuf_rt::get(in, block_decoded) && block_decoded.size() == floats.size(); }), block_size);
+    return 0;
+}
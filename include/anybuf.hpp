@@ -1,9 +1,20 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <array>
+#include <chrono>
 #include <vector>
+#include <memory>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
 #include <fstream>
+#include <new>
+#include <mutex>
+#include <type_traits>
 
 namespace anybuf
 {
@@ -33,7 +44,7 @@ namespace anybuf
 
         import
     };
-    inline const char *keyword(identity identifier)
+    constexpr const char *keyword(identity identifier) noexcept
     {
         switch (identifier)
         {
@@ -74,6 +85,41 @@ namespace anybuf
         }
     }
 
+    /** perfect hash of the keywords, the table below is checked collision free at compile time */
+    constexpr std::size_t keyword_hash(std::string_view text) noexcept
+    {
+        return (text.size() + static_cast<unsigned char>(text[0]) + 2 * static_cast<unsigned char>(text[text.size() - 1])) & 31;
+    }
+    struct keyword_table
+    {
+        identity slots[32] = {};
+        bool perfect = true;
+
+        constexpr keyword_table() noexcept
+        {
+            for (auto identifier = static_cast<int>(identity::u8); identifier <= static_cast<int>(identity::import); ++identifier)
+            {
+                if (auto word = keyword(static_cast<identity>(identifier)); word)
+                {
+                    auto &slot = slots[keyword_hash(word)];
+                    perfect = perfect && slot == identity();
+                    slot = static_cast<identity>(identifier);
+                }
+            }
+        }
+    };
+    inline constexpr keyword_table keywords;
+    static_assert(keywords.perfect, "keyword_hash has collisions");
+
+    /** identity of the keyword, or identity() if text isn't a keyword */
+    constexpr identity keyword(std::string_view text) noexcept
+    {
+        if (text.size() < 2 || text.size() > 6)
+            return identity();
+        auto identifier = keywords.slots[keyword_hash(text)];
+        return identifier != identity() && text == keyword(identifier) ? identifier : identity();
+    }
+
     enum class node_type
     {
         type,
@@ -100,9 +146,9 @@ namespace anybuf
         virtual ~node() noexcept {}
 
         node_type type() const noexcept { return _type; }
-        virtual void free() noexcept {}
     };
 
+    /** shared by every use of the same type, don't modify */
     class type_node : public node
     {
     public:
@@ -113,8 +159,6 @@ namespace anybuf
 
     public:
         type_node() noexcept : node(node_type::type) {}
-
-        void free() noexcept override;
     };
 
     class content_node : public node
@@ -122,12 +166,15 @@ namespace anybuf
         using node::node;
 
     public:
-        std::string src;
-        std::size_t row;
-        std::size_t col;
+        /** index of the source in reader::files() */
+        std::uint32_t file = 0;
+        std::uint32_t row = 0;
+        std::uint32_t col = 0;
 
         std::string_view comment;
         std::string_view name;
+        /** dotted name from the outermost scope, interned in the reader's string pool */
+        std::string_view qualified_name;
 
     public:
         content_node *parent = nullptr;
@@ -139,8 +186,6 @@ namespace anybuf
 
     public:
         emodule_node() noexcept : content_node(node_type::emodule) {}
-
-        void free() noexcept override;
     };
     class eenum_member_node : public content_node
     {
@@ -161,8 +206,6 @@ namespace anybuf
 
     public:
         eenum_node() noexcept : content_node(node_type::eenum) {}
-
-        void free() noexcept override;
     };
     class estruct_member_node : public content_node
     {
@@ -173,8 +216,6 @@ namespace anybuf
 
     public:
         estruct_member_node() noexcept : content_node(node_type::estruct_member) {}
-
-        void free() noexcept override;
     };
     class estruct_node : public content_node
     {
@@ -185,45 +226,206 @@ namespace anybuf
 
     public:
         estruct_node() noexcept : content_node(node_type::estruct) {}
-
-        void free() noexcept override;
     };
 
-    inline void type_node::free() noexcept
+    /** overload set of lambdas for visit */
+    template <typename... Visitors>
+    struct overloaded : Visitors...
+    {
+        using Visitors::operator()...;
+    };
+    template <typename... Visitors>
+    overloaded(Visitors...) -> overloaded<Visitors...>;
+
+    /**
+     * call the visitor with the node cast to its type by node::type(),
+     * the visitor should accept every node type and return the same type for all
+     * @param node node or const node
+     */
+    template <typename Node, typename Visitor>
+    decltype(auto) visit(Node *node, Visitor &&visitor)
     {
-        for (auto value : values)
+        static_assert(std::is_base_of_v<anybuf::node, std::remove_const_t<Node>>, "Node should be a node");
+        // keep the constness of the node
+        using type = std::conditional_t<std::is_const_v<Node>, const type_node, type_node>;
+        using emodule = std::conditional_t<std::is_const_v<Node>, const emodule_node, emodule_node>;
+        using eenum = std::conditional_t<std::is_const_v<Node>, const eenum_node, eenum_node>;
+        using eenum_member = std::conditional_t<std::is_const_v<Node>, const eenum_member_node, eenum_member_node>;
+        using estruct = std::conditional_t<std::is_const_v<Node>, const estruct_node, estruct_node>;
+        using estruct_member = std::conditional_t<std::is_const_v<Node>, const estruct_member_node, estruct_member_node>;
+
+        static_assert(std::is_invocable_v<Visitor, type *> && std::is_invocable_v<Visitor, emodule *> &&
+                          std::is_invocable_v<Visitor, eenum *> && std::is_invocable_v<Visitor, eenum_member *> &&
+                          std::is_invocable_v<Visitor, estruct *> && std::is_invocable_v<Visitor, estruct_member *>,
+                      "the visitor should accept every node type");
+        using result = std::invoke_result_t<Visitor, type *>;
+        static_assert(std::is_same_v<result, std::invoke_result_t<Visitor, emodule *>> && std::is_same_v<result, std::invoke_result_t<Visitor, eenum *>> &&
+                          std::is_same_v<result, std::invoke_result_t<Visitor, eenum_member *>> && std::is_same_v<result, std::invoke_result_t<Visitor, estruct *>> &&
+                          std::is_same_v<result, std::invoke_result_t<Visitor, estruct_member *>>,
+                      "the visitor should return the same type for every node type");
+
+        auto target = static_cast<std::conditional_t<std::is_const_v<Node>, const anybuf::node, anybuf::node> *>(node);
+        switch (target->type())
         {
-            if (value->type() == node_type::type)
-                dynamic_cast<type_node *>(value)->free();
+        case node_type::type:
+            return visitor(static_cast<type *>(target));
+        case node_type::emodule:
+            return visitor(static_cast<emodule *>(target));
+        case node_type::eenum:
+            return visitor(static_cast<eenum *>(target));
+        case node_type::eenum_member:
+            return visitor(static_cast<eenum_member *>(target));
+        case node_type::estruct:
+            return visitor(static_cast<estruct *>(target));
+        case node_type::estruct_member:
+        default:
+            return visitor(static_cast<estruct_member *>(target));
         }
     }
-    inline void emodule_node::free() noexcept
+
+    /** bases of the struct without the ones another base derives from, the bases a struct encodes first */
+    std::vector<estruct_node *> direct_bases(const estruct_node *node);
+
+    /** bytes of a value on the wire */
+    struct encoded_size
     {
-        for (auto member : members)
-            member->free();
-        members.clear();
-    }
-    inline void eenum_node::free() noexcept
+        std::size_t min = 0;
+        /** meaningful only when bounded */
+        std::size_t max = 0;
+        /** false when a str, array or map, in the value or in a struct it holds, lets it grow without limit */
+        bool bounded = true;
+    };
+    /** encoded sizes of the structs, each struct computed once, a struct holding itself is unbounded */
+    class size_table final
     {
-        for (auto member : members)
-            member->free();
-        members.clear();
-    }
-    inline void estruct_member_node::free() noexcept
+    private:
+        std::unordered_map<const estruct_node *, encoded_size> _sizes;
+
+    public:
+        /** the struct with its bases, the field count and the present fields */
+        encoded_size size(const estruct_node *node) noexcept;
+        encoded_size size(const type_node *node) noexcept;
+        /** forget the structs, before the nodes are released */
+        void clear() noexcept { _sizes.clear(); }
+    };
+
+    /** read-only content of a file, memory mapped when possible */
+    class mapping final
     {
-        if (format)
+    private:
+        const char *_data = nullptr;
+        std::size_t _size = 0;
+        /** fallback storage when the file can't be mapped */
+        std::unique_ptr<char[]> _buffer;
+#ifdef WIN32
+        void *_file = nullptr;
+        void *_map = nullptr;
+#endif
+
+    public:
+        mapping() noexcept {}
+        mapping(const mapping &) = delete;
+        mapping(mapping &&) = delete;
+        mapping &operator=(const mapping &) = delete;
+        mapping &operator=(mapping &&) = delete;
+        ~mapping() noexcept { close(); }
+
+        /** map the file, the content stays valid until close */
+        bool open(const std::string &path) noexcept;
+        void close() noexcept;
+
+        std::string_view data() const noexcept { return std::string_view(_data, _size); }
+    };
+
+    /** bump allocator of nodes, the nodes are destroyed together and the memory is reused */
+    class node_arena final
+    {
+    private:
+        struct chunk
+        {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        static constexpr std::size_t chunk_size = 64 * 1024;
+
+        std::vector<chunk> _chunks;
+        /** chunk in use and the offset in it */
+        std::size_t _chunk = 0;
+        std::size_t _offset = 0;
+        /** nodes in creation order */
+        std::vector<node *> _nodes;
+
+    private:
+        void *allocate(std::size_t size, std::size_t align);
+
+    public:
+        node_arena() noexcept {}
+        node_arena(const node_arena &) = delete;
+        node_arena(node_arena &&) = delete;
+        node_arena &operator=(const node_arena &) = delete;
+        node_arena &operator=(node_arena &&) = delete;
+        ~node_arena() noexcept { clear(); }
+
+        template <typename T>
+        T *create()
         {
-            format->free();
-            format = nullptr;
+            static_assert(std::is_base_of_v<node, T>, "T should be a node");
+            auto node = new (allocate(sizeof(T), alignof(T))) T();
+            _nodes.push_back(node);
+            return node;
         }
-    }
-    inline void estruct_node::free() noexcept
+        /** destroy all nodes, keep the chunks for the next nodes */
+        void clear() noexcept;
+        /** bytes of the chunks, the most the nodes have taken */
+        std::size_t capacity() const noexcept;
+    };
+
+    /** stable storage of strings, interned strings are kept once, safe to use from several threads */
+    class string_pool final
     {
-        for (auto member : members)
-            member->free();
-        members.clear();
-        bases.clear();
-    }
+    private:
+        struct chunk
+        {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        static constexpr std::size_t chunk_size = 16 * 1024;
+
+        std::vector<chunk> _chunks;
+        /** chunk in use and the offset in it */
+        std::size_t _chunk = 0;
+        std::size_t _offset = 0;
+        std::unordered_set<std::string_view> _interned;
+        mutable std::mutex _lock;
+
+    private:
+        std::string_view copy(std::string_view text);
+
+    public:
+        string_pool() noexcept {}
+        string_pool(const string_pool &) = delete;
+        string_pool(string_pool &&) = delete;
+        string_pool &operator=(const string_pool &) = delete;
+        string_pool &operator=(string_pool &&) = delete;
+
+        /** copy the text into the pool */
+        std::string_view store(std::string_view text);
+        /** the pooled copy of the text, equal texts share one copy */
+        std::string_view intern(std::string_view text);
+        /** the interned copy of the text, or an empty view without data */
+        std::string_view find(std::string_view text) const noexcept
+        {
+            std::lock_guard lock(_lock);
+            auto iter = _interned.find(text);
+            return iter != _interned.end() ? *iter : std::string_view();
+        }
+        /** drop all strings, keep the chunks for the next strings */
+        void clear() noexcept;
+        /** bytes of the chunks, the most the strings have taken */
+        std::size_t capacity() const noexcept;
+    };
 } // namespace anybuf
 
 namespace anybuf
@@ -233,35 +435,53 @@ namespace anybuf
     private:
         struct token
         {
-            std::size_t row;
-            std::size_t col;
-            std::string text;
+            enum class kind_type
+            {
+                punctuation,
+                identifier,
+                keyword,
+                number,
+                string,
+                comment
+            };
+
+            std::uint32_t row;
+            std::uint32_t col;
+            /** view into the source content */
+            std::string_view text;
+            kind_type kind;
+            /** identity of a keyword */
+            identity identifier = identity();
 
-            token(std::size_t row, std::size_t col, const std::string &text) noexcept : row(row), col(col), text(text) {}
+            token(std::size_t row, std::size_t col, std::string_view text) noexcept : row(static_cast<std::uint32_t>(row)), col(static_cast<std::uint32_t>(col)), text(text) { kind = classify(text, identifier); }
 
-            bool is_string() const noexcept { return text.size() > 1 && text[0] == '"' && text[text.size() - 1] == '"'; }
-            bool is_line_comment() const noexcept { return text.size() > 1 && text[0] == '/' && text[1] == '/'; }
-            bool is_block_comment() const noexcept { return text.size() > 1 && text[0] == '/' && text[1] == '*'; }
-            bool is_comment() const noexcept { return is_line_comment() || is_block_comment(); }
-            bool is_entity_name(bool strict = true) const noexcept
+            static kind_type classify(std::string_view text, identity &identifier) noexcept
             {
-                for (decltype(text.size()) i = 0; i < text.size(); ++i)
+                auto size = text.size();
+                if (size > 1 && text[0] == '"' && text[size - 1] == '"')
+                    return kind_type::string;
+                if (size > 1 && text[0] == '/' && (text[1] == '/' || text[1] == '*'))
+                    return kind_type::comment;
+                if (size > 0 && text[0] >= '0' && text[0] <= '9')
+                    return kind_type::number;
+                for (decltype(size) i = 0; i < size; ++i)
                 {
                     if (text[i] != '_' && (text[i] < 'A' || text[i] > 'Z') && (text[i] < 'a' || text[i] > 'z') && (i == 0 || (text[i] < '0' || text[i] > '9')))
-                        return false;
+                        return kind_type::punctuation;
                 }
-                if (!strict)
-                    return text.size() > 0;
-
-                return text.size() > 0 &&
-                       text != keyword(identity::i8) && text != keyword(identity::i16) && text != keyword(identity::i32) && text != keyword(identity::i64) &&
-                       text != keyword(identity::u8) && text != keyword(identity::u16) && text != keyword(identity::u32) && text != keyword(identity::u64) &&
-                       text != keyword(identity::f32) && text != keyword(identity::f64) &&
-                       text != keyword(identity::boolean) && text != keyword(identity::str) &&
-                       text != keyword(identity::emodule) && text != keyword(identity::eenum) && text != keyword(identity::estruct) &&
-                       text != keyword(identity::import);
+                if (size == 0)
+                    return kind_type::punctuation;
+                identifier = keyword(text);
+                return identifier != identity() ? kind_type::keyword : kind_type::identifier;
             }
 
+            bool is_string() const noexcept { return kind == kind_type::string; }
+            bool is_line_comment() const noexcept { return kind == kind_type::comment && text[1] == '/'; }
+            bool is_block_comment() const noexcept { return kind == kind_type::comment && text[1] == '*'; }
+            bool is_comment() const noexcept { return kind == kind_type::comment; }
+            bool is_entity_name(bool strict = true) const noexcept { return kind == kind_type::identifier || (!strict && kind == kind_type::keyword); }
+            bool is(identity identifier) const noexcept { return kind == kind_type::keyword && this->identifier == identifier; }
+
             bool operator==(const std::string &token) const noexcept { return text == token; }
             bool operator==(const std::string_view &token) const noexcept { return text == token; }
             bool operator==(const char *token) const noexcept { return text == token; }
@@ -269,22 +489,107 @@ namespace anybuf
             bool operator!=(const std::string_view &token) const noexcept { return text != token; }
             bool operator!=(const char *token) const noexcept { return text != token; }
         };
+        /**
+         * declarations of a scope, keyed by interned name; a module reopened anywhere shares one table,
+         * a source reopening a module of its imports declares into a table of its own linked to the shared one
+         */
+        struct symbol_table
+        {
+            struct symbol
+            {
+                /** module, enum, struct */
+                content_node *node;
+                /** members of a module or struct */
+                symbol_table *table;
+            };
+
+            symbol_table *parent;
+            /** table of the same scope published by the imports */
+            const symbol_table *shared;
+            /** keyed by the data of the interned name */
+            std::unordered_map<const char *, symbol> symbols;
+
+            explicit symbol_table(symbol_table *parent = nullptr, const symbol_table *shared = nullptr) noexcept : parent(parent), shared(shared) {}
+
+            /** the symbol of the name declared in a visible file */
+            const symbol *find(std::string_view name, const std::vector<bool> &visible) const noexcept
+            {
+                if (auto iter = symbols.find(name.data()); iter != symbols.end())
+                {
+                    // modules are open to everyone, their members are checked by file
+                    auto node = iter->second.node;
+                    if (node->type() == node_type::emodule || (node->file < visible.size() && visible[node->file]))
+                        return &iter->second;
+                }
+                return shared ? shared->find(name, visible) : nullptr;
+            }
+        };
         struct source
         {
             enum class status_type
             {
                 none,
+                /** opened and scanned, or its cache entry taken */
+                scanned,
+                /** its imports are being resolved */
                 reading,
-                read
+                /** waiting for its level of the import graph */
+                ready,
+                read,
+                failed
+            };
+            struct import_file
+            {
+                source *src;
+                /** position of the path token */
+                std::vector<token>::size_type pos;
             };
 
+            /** index in files */
+            std::uint32_t file = 0;
+            mapping content;
+            /** tokens view into content */
             std::vector<token> tokens;
             status_type status = status_type::none;
+
+            /** hash of the content, and of the content and the keys of the imports */
+            std::uint64_t hash = 0;
+            std::uint64_t key = 0;
+            /** write time and size of the file before it was opened, a reload hashes the file again only once they change */
+            std::int64_t time = 0;
+            std::uint64_t size = 0;
+            /** the declarations of the last read are kept by a reload, the source isn't read again */
+            bool kept = false;
+            /** cache entry of the content, empty if there's none or the source is read from its tokens */
+            std::string cache;
+
+            /** existing files of the leading import statements */
+            std::vector<import_file> imports;
+            /** longest import chain below the source, sources of a level are read together */
+            std::size_t level = 0;
+            /** files whose declarations the source sees: itself and its imports, recursively */
+            std::vector<bool> visible;
+
+            /** top level declarations of the source, published to the reader's table once read */
+            symbol_table symbols;
+            /** module and struct scopes */
+            std::deque<symbol_table> tables;
+            /** top level nodes */
+            std::vector<content_node *> nodes;
+            std::vector<std::string> errors;
+
+            /** times of the source, measured if the reader measures */
+            std::chrono::nanoseconds scan_time{};
+            std::chrono::nanoseconds read_time{};
+            std::chrono::nanoseconds resolve_time{};
         };
         struct context
         {
             const std::string path;
+            const std::uint32_t file;
             source &src;
+            /** arena of the worker reading the source */
+            node_arena &arena;
             const std::vector<token>::size_type size;
 
             std::vector<token>::size_type pos;
@@ -292,8 +597,10 @@ namespace anybuf
 
             /** module, struct */
             std::vector<content_node *> scopes;
+            /** symbol table of each scope */
+            std::vector<symbol_table *> tables;
 
-            context(const std::string &path, source &src) : path(path), src(src), size(src.tokens.size()), pos(0), comment(-1) {}
+            context(const std::string &path, source &src, node_arena &arena) : path(path), file(src.file), src(src), arena(arena), size(src.tokens.size()), pos(0), comment(-1) {}
 
             const token &curr() const { return src.tokens[pos]; }
             const token &next() const { return src.tokens[pos + 1]; }
@@ -303,7 +610,7 @@ namespace anybuf
             {
                 auto &token = src.tokens[pos];
                 return path + ':' + std::to_string(token.row) + ':' + std::to_string(token.col) +
-                       ' ' + (token.is_string() ? token.text : "\"" + token.text + "\"") +
+                       ' ' + (token.is_string() ? std::string(token.text) : "\"" + std::string(token.text) + "\"") +
                        ": " + desc;
             }
             std::string error(const char *desc = "syntax error") const { return error(pos, desc); }
@@ -315,21 +622,99 @@ namespace anybuf
             }
         };
 
+        /** layout of the cache entries, entries of another version or of another build of the compiler are ignored */
+        static constexpr std::uint32_t cache_version = 2;
+
+    public:
+        struct file_stats
+        {
+            /** tokens scanned, 0 if the declarations came from the cache entry or were kept by a reload */
+            std::size_t tokens = 0;
+            bool cached = false;
+            std::chrono::nanoseconds scan{};
+            /** parsing, or loading the cache entry, resolve included */
+            std::chrono::nanoseconds read{};
+            /** looking up the names of bases and member types */
+            std::chrono::nanoseconds resolve{};
+        };
+        struct statistics
+        {
+            /** indexed by content_node::file */
+            std::vector<file_stats> files;
+            /** nodes of each node_type, the type nodes are the distinct types */
+            std::array<std::size_t, 6> nodes{};
+            /** bytes of the node arenas and the string pool, they keep their chunks at the peak */
+            std::size_t memory = 0;
+        };
+
     private:
         std::map<std::string, source> _sources;
         std::vector<content_node *> _nodes;
 
+        /** source paths, indexed by content_node::file */
+        std::vector<std::string> _files;
+        /** names, qualified names and released comments */
+        string_pool _strings;
+        /** top level declarations of the read sources */
+        symbol_table _symbols;
+        /** tables of the published modules, merging the modules of the sources, whose tables stay as they were read */
+        std::deque<symbol_table> _published;
+        /** owners of all nodes, one for each worker */
+        std::deque<node_arena> _arenas;
+        /** distinct types, each after the types it's made of */
+        std::vector<type_node *> _types;
+        /** type nodes by the hash of format and values */
+        std::unordered_multimap<std::size_t, type_node *> _type_index;
+        std::mutex _type_lock;
+
         std::vector<std::string> _errors;
+        /** directory of the cache entries, empty if the cache is off */
+        std::string _cache;
+        /** paths given to load, loaded again by reload */
+        std::vector<std::string> _roots;
+        /** cache entries of the sources read before a rebuild, by path */
+        std::map<std::string, std::string> _entries;
+        /** sources read again by reloads since the last rebuild, the nodes they replaced are left in the arenas */
+        std::size_t _reread = 0;
+        /** files read from their tokens, or gone */
+        std::vector<std::string> _changed;
+        /** measure the times of the sources */
+        bool _measure = false;
+        statistics _stats;
 
     private:
-        /** scan the file */
-        void scan(const std::string &path) noexcept;
+        /** the source of the file, added unscanned if it's new */
+        source &add(const std::string &path);
+        /** split the content of the source into tokens */
+        void scan(source &src) noexcept;
+        /** open the source and look for its cache entry, scan it if there's none */
+        void prepare(source &src);
+        /** find the files of the leading import statements, or take them from the cache entry */
+        void scan_imports(source &src);
+        /** resolve the imports recursively, the order lists every source after its imports */
+        bool resolve(source &src, std::vector<source *> &order);
+        /** merge the declarations of a read source into the published table */
+        void publish(symbol_table &from, symbol_table &to, std::vector<content_node *> &conflicts);
+        /** clear and read the loaded paths again, the read sources restored from cache entries in memory */
+        [[nodiscard]] bool rebuild() noexcept;
 
         /** read comment node */
         void read_comment(context &context) noexcept;
         [[nodiscard]] bool read_to_next(context &context, bool (*where)(const token &) = nullptr, const char *desc = "syntax error") noexcept;
         [[nodiscard]] bool read_number(context &context, uint64_t &value, bool &negative) noexcept;
+        /** create a node in the file of the context */
+        template <typename T>
+        T *create(context &context, std::string_view name, std::uint32_t row, std::uint32_t col, std::string_view comment, content_node *parent);
+        /** create a node named by the token at name, in the file of the context */
+        template <typename T>
+        T *create(context &context, std::vector<token>::size_type name, std::vector<token>::size_type comment, content_node *parent);
+        /** declare the node in the innermost scope, table is the scope of a module or struct */
+        void declare(context &context, content_node *node, symbol_table *table = nullptr);
+        /** the table of the module in the scope table, symbol is the module found from the scope */
+        symbol_table *open(context &context, symbol_table *table, emodule_node *node, const symbol_table::symbol *symbol);
         [[nodiscard]] content_node *read_scopes(context &context, const std::vector<std::size_t> &names, bool upward = false) const;
+        /** the type node of the format and values, structurally identical types share one node */
+        type_node *make_type(context &context, identity format, std::vector<node *> &&values);
         [[nodiscard]] type_node *read_type(context &context) noexcept;
         /** read import node */
         [[nodiscard]] bool read_import(context &context) noexcept;
@@ -340,7 +725,11 @@ namespace anybuf
         /** read struct node */
         [[nodiscard]] bool read_estruct(context &context) noexcept;
         /** read the source */
-        [[nodiscard]] bool read(const std::string &path, source &src) noexcept;
+        [[nodiscard]] bool read(source &src, node_arena &arena) noexcept;
+        /** load the declarations of the source from its cache entry, false if the entry is stale */
+        [[nodiscard]] bool read_cache(source &src, node_arena &arena);
+        /** the cache entry of the read source */
+        std::string write_cache(const source &src) const;
 
     public:
         reader() noexcept {}
@@ -350,20 +739,302 @@ namespace anybuf
         reader &operator=(reader &&) = delete;
         ~reader() noexcept { clear(); }
 
+        /**
+         * keep the declarations of the read sources in the directory,
+         * a source unchanged since, with unchanged imports, is loaded from there instead of read again
+         * @param path directory of the cache, empty to turn the cache off
+         */
+        void cache(const std::string &path) noexcept { _cache = path; }
+        /**
+         * measure the scan, read and resolve times of the sources, off by default
+         * @param enable measure or not
+         */
+        void measure(bool enable) noexcept { _measure = enable; }
         /**
          * load a file or a directory
          * @param path path of the file
          */
         void load(const std::string &path) noexcept;
-        /** read sources */
+        /**
+         * open and scan the loaded sources and the files they import, read runs this first
+         * @return count of the tokens scanned
+         */
+        std::size_t scan() noexcept;
+        /**
+         * read sources, sources on the same level of the import graph are read concurrently,
+         * a source sees the declarations of its imports only
+         */
         [[nodiscard]] bool read() noexcept;
+        /**
+         * read the loaded paths again, keeping the declarations of the read sources in memory,
+         * only the changed sources and the sources importing them are scanned and read;
+         * once the sources read again outnumber the sources, the nodes are rebuilt to drop the replaced ones
+         */
+        [[nodiscard]] bool reload() noexcept;
         /** clear */
         void clear() noexcept;
+        /**
+         * drop the tokens and the content of the read sources,
+         * names and comments of the nodes are moved into the string pool first
+         */
+        void release_sources() noexcept;
+        /**
+         * warnings about declarations expensive on the wire or in memory: maps keyed by str,
+         * arrays of structs with mostly optional fields, deep type nesting and inheritance,
+         * and enums wider than their values, and about sparse field indices, which use up the 256 of a struct
+         */
+        std::vector<std::string> lint() const;
 
         /** module, enum, struct */
         const std::vector<content_node *> &nodes() const noexcept { return _nodes; }
+        /** distinct types of the struct members, each after the types it's made of */
+        const std::vector<type_node *> &types() const noexcept { return _types; }
+        /** source paths, indexed by content_node::file */
+        const std::vector<std::string> &files() const noexcept { return _files; }
         /** errors */
         const std::vector<std::string> &errors() const noexcept { return _errors; }
+        /** files read from their tokens by the last read, or gone since the read before, the others are restored unchanged */
+        const std::vector<std::string> &changed() const noexcept { return _changed; }
+        /** statistics of the last read, the times are zero unless measured */
+        const statistics &stats() const noexcept { return _stats; }
+    };
+} // namespace anybuf
+
+namespace anybuf
+{
+    /**
+     * compiled schema (.anybufc): the resolved nodes and types of a reader in one flat file,
+     * read in place from its mapping through views shaped like the nodes;
+     * records are in the byte order of the machine and refer to each other by offset in the file
+     */
+    class schema final
+    {
+    public:
+        static constexpr std::uint32_t version = 1;
+
+        /** offset and count of an array of record offsets, or offset and size of a string */
+        struct span
+        {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+        struct header_record
+        {
+            char magic[4];
+            std::uint32_t version;
+            /** size of the file */
+            std::uint32_t size;
+            std::uint32_t reserved;
+            /** string spans of the source paths */
+            span files;
+            /** top level node records */
+            span nodes;
+            /** distinct type records, each after the types it's made of */
+            span types;
+        };
+        /** module, enum, enum member, struct and struct member, the fields not of the node type are zero */
+        struct node_record
+        {
+            std::uint32_t type;
+            std::uint32_t file;
+            std::uint32_t row;
+            std::uint32_t col;
+            /** offset of the parent node record, 0 at the top level */
+            std::uint32_t parent;
+            /** identity of an enum, offset of the type record of a struct member */
+            std::uint32_t format;
+            std::uint8_t index;
+            std::uint8_t optional;
+            std::uint16_t reserved;
+            std::uint32_t reserved2;
+            std::int64_t value;
+            span name;
+            span qualified_name;
+            span comment;
+            span members;
+            span bases;
+        };
+        struct type_record
+        {
+            std::uint32_t format;
+            /** type records, or the enum or struct node record */
+            span values;
+        };
+
+        template <typename View>
+        class list_view
+        {
+        private:
+            const char *_base = nullptr;
+            span _span = {};
+
+        public:
+            class iterator
+            {
+            private:
+                const char *_base;
+                const std::uint32_t *_offset;
+
+            public:
+                iterator(const char *base, const std::uint32_t *offset) noexcept : _base(base), _offset(offset) {}
+                View operator*() const noexcept { return View(_base, *_offset); }
+                iterator &operator++() noexcept
+                {
+                    ++_offset;
+                    return *this;
+                }
+                bool operator==(const iterator &other) const noexcept { return _offset == other._offset; }
+                bool operator!=(const iterator &other) const noexcept { return _offset != other._offset; }
+            };
+
+            list_view() noexcept {}
+            list_view(const char *base, span span) noexcept : _base(base), _span(span) {}
+
+            std::size_t size() const noexcept { return _span.size; }
+            View operator[](std::size_t index) const noexcept { return View(_base, offsets()[index]); }
+            iterator begin() const noexcept { return iterator(_base, offsets()); }
+            iterator end() const noexcept { return iterator(_base, offsets() + _span.size); }
+
+        private:
+            const std::uint32_t *offsets() const noexcept { return reinterpret_cast<const std::uint32_t *>(_base + _span.offset); }
+        };
+
+        class type_view;
+        /** view of a node record, what the node of the type doesn't have is empty */
+        class node_view
+        {
+        private:
+            const char *_base = nullptr;
+            const node_record *_record = nullptr;
+
+            std::string_view text(span span) const noexcept { return std::string_view(_base + span.offset, span.size); }
+
+        public:
+            node_view() noexcept {}
+            node_view(const char *base, std::uint32_t offset) noexcept : _base(base), _record(offset ? reinterpret_cast<const node_record *>(base + offset) : nullptr) {}
+
+            explicit operator bool() const noexcept { return _record; }
+            bool operator==(const node_view &other) const noexcept { return _record == other._record; }
+            bool operator!=(const node_view &other) const noexcept { return _record != other._record; }
+
+            node_type type() const noexcept { return static_cast<node_type>(_record->type); }
+            /** index of the source in schema::files() */
+            std::uint32_t file() const noexcept { return _record->file; }
+            std::uint32_t row() const noexcept { return _record->row; }
+            std::uint32_t col() const noexcept { return _record->col; }
+            std::string_view name() const noexcept { return text(_record->name); }
+            std::string_view qualified_name() const noexcept { return text(_record->qualified_name); }
+            std::string_view comment() const noexcept { return text(_record->comment); }
+            node_view parent() const noexcept { return node_view(_base, _record->parent); }
+
+            /** members of a module, enum or struct */
+            list_view<node_view> members() const noexcept { return list_view<node_view>(_base, _record->members); }
+            /** bases of a struct */
+            list_view<node_view> bases() const noexcept { return list_view<node_view>(_base, _record->bases); }
+            /** format of an enum */
+            identity format() const noexcept { return static_cast<identity>(_record->format); }
+            /** value of an enum member */
+            std::int64_t value() const noexcept { return _record->value; }
+            /** index, optional and type of a struct member */
+            std::uint8_t index() const noexcept { return _record->index; }
+            bool optional() const noexcept { return _record->optional; }
+            type_view member_type() const noexcept;
+        };
+        /** view of a type record */
+        class type_view
+        {
+        private:
+            const char *_base = nullptr;
+            const type_record *_record = nullptr;
+
+        public:
+            type_view() noexcept {}
+            type_view(const char *base, std::uint32_t offset) noexcept : _base(base), _record(offset ? reinterpret_cast<const type_record *>(base + offset) : nullptr) {}
+
+            explicit operator bool() const noexcept { return _record; }
+            /** equal types share one record */
+            bool operator==(const type_view &other) const noexcept { return _record == other._record; }
+            bool operator!=(const type_view &other) const noexcept { return _record != other._record; }
+
+            identity format() const noexcept { return static_cast<identity>(_record->format); }
+            /** element of an array, elements of a tuple, key and value of a map */
+            list_view<type_view> values() const noexcept { return list_view<type_view>(_base, _record->values); }
+            /** the enum or struct */
+            node_view node() const noexcept { return node_view(_base, *reinterpret_cast<const std::uint32_t *>(_base + _record->values.offset)); }
+        };
+
+    private:
+        mapping _content;
+        const header_record *_header = nullptr;
+
+        /** every record the header reaches, its spans and its offsets are in the file and aligned, the views read them unchecked */
+        static bool check(std::string_view data) noexcept;
+
+    public:
+        schema() noexcept {}
+        schema(const schema &) = delete;
+        schema(schema &&) = delete;
+        schema &operator=(const schema &) = delete;
+        schema &operator=(schema &&) = delete;
+
+        /**
+         * compile the nodes of the reader into a file
+         * @param path path of the file
+         */
+        static bool write(const std::string &path, const reader &reader) noexcept;
+        /**
+         * map a compiled file, the views stay valid until close
+         * @param path path of the file
+         */
+        bool open(const std::string &path) noexcept;
+        void close() noexcept;
+
+        /** module, enum, struct */
+        list_view<node_view> nodes() const noexcept { return _header ? list_view<node_view>(_content.data().data(), _header->nodes) : list_view<node_view>(); }
+        /** distinct types of the struct members, each after the types it's made of */
+        list_view<type_view> types() const noexcept { return _header ? list_view<type_view>(_content.data().data(), _header->types) : list_view<type_view>(); }
+        /** source paths, indexed by node_view::file */
+        std::vector<std::string_view> files() const noexcept;
+    };
+    inline schema::type_view schema::node_view::member_type() const noexcept { return type_view(_base, type() == node_type::estruct_member ? _record->format : 0); }
+} // namespace anybuf
+
+namespace anybuf
+{
+    /** reports changed files under the watched paths, with inotify on linux and by polling elsewhere */
+    class watcher final
+    {
+    private:
+        /** watched files and directories */
+        std::vector<std::string> _paths;
+#ifdef __linux__
+        int _fd = -1;
+        /** watched directory of each watch descriptor */
+        std::map<int, std::string> _directories;
+
+        void add(const std::string &directory) noexcept;
+#else
+        /** last write time of each file */
+        std::map<std::string, long long> _times;
+
+        std::map<std::string, long long> snapshot() const noexcept;
+#endif
+
+    public:
+        watcher() noexcept;
+        watcher(const watcher &) = delete;
+        watcher(watcher &&) = delete;
+        watcher &operator=(const watcher &) = delete;
+        watcher &operator=(watcher &&) = delete;
+        ~watcher() noexcept;
+
+        /**
+         * watch a file or a directory with its subdirectories
+         * @param path path of the file
+         */
+        bool watch(const std::string &path) noexcept;
+        /** block until files change, changes closely following each other are reported together */
+        std::vector<std::string> wait() noexcept;
     };
 } // namespace anybuf
 
@@ -371,58 +1042,116 @@ namespace anybuf
 {
     class writer
     {
+    public:
+        /** files of the output */
+        enum class split_type
+        {
+            /** one file at the path */
+            none,
+            /** a file for each top level module and each declaration outside modules */
+            emodule,
+            /** a file for each enum and struct outside structs */
+            declaration
+        };
+        struct output_file
+        {
+            std::string path;
+            std::string content;
+            /** the last commit changed the file */
+            bool written = false;
+        };
+
     protected:
         std::string path;
         std::string package;
 
         std::vector<std::string> _errors;
+        /** supported by the writers that can split their output, the others write one file */
+        split_type _split = split_type::none;
+        /** time of the last write */
+        std::chrono::nanoseconds _time{};
+
+    private:
+        /** files of the last render */
+        std::vector<output_file> _files;
+        /** files of the last commit, the ones not rendered again are removed */
+        std::unordered_set<std::string> _committed;
+        /** qualified names of the types to write, all if empty */
+        std::vector<std::string> _roots;
+        /** the roots and what they refer to, with the modules and structs around them */
+        std::unordered_set<const content_node *> _reachable;
+
+        /** find the nodes reachable from the roots */
+        bool reach(const std::vector<content_node *> &nodes);
 
     protected:
-        virtual bool write_type(std::ofstream &stream, type_node *node) noexcept = 0;
-        virtual bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept = 0;
-        virtual bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept = 0;
-        virtual bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept = 0;
+        virtual bool write_type(std::string &output, type_node *node) noexcept = 0;
+        virtual bool write_emodule(std::string &output, emodule_node *node) noexcept = 0;
+        virtual bool write_eenum(std::string &output, eenum_node *node) noexcept = 0;
+        virtual bool write_estruct(std::string &output, estruct_node *node) noexcept = 0;
+
+        /** write the files of the nodes, one file at the path with every node by default */
+        virtual bool write_files(const std::vector<content_node *> &nodes) noexcept;
+        /** add a file to the output */
+        void add_file(const std::string &path, std::string &&content) { _files.push_back(output_file{path, std::move(content)}); }
+
+        /** the roots reach the node, or there are no roots */
+        bool reached(const content_node *node) const noexcept { return _roots.size() == 0 || _reachable.count(node) > 0; }
+        /** write a module, enum or struct, unless the roots don't reach it */
+        bool write_node(std::string &output, content_node *node) noexcept
+        {
+            if (!reached(node))
+                return true;
+            return visit(node, overloaded{
+                                   [&](emodule_node *node) { return write_emodule(output, node); },
+                                   [&](eenum_node *node) { return write_eenum(output, node); },
+                                   [&](estruct_node *node) { return write_estruct(output, node); },
+                                   [](anybuf::node *) { return true; },
+                               });
+        }
 
     public:
-        /** 
+        /**
          * @param path output file path
-         * @param package root namespace or empty 
+         * @param package root namespace or empty
          */
         writer(const std::string &path, const std::string &package = "") noexcept : path(path), package(package) {}
+        virtual ~writer() noexcept {}
+        /**
+         * write only the given types and the enums and structs they refer to by bases and member types, recursively
+         * @param names qualified names of enums, structs or modules, all of a module is written, empty for all types
+         */
+        void roots(const std::vector<std::string> &names) { _roots = names; }
+        /** write the files of the writers that can split their output */
+        void split(split_type type) noexcept { _split = type; }
+        /** write the nodes into the files in memory, the files on disk aren't touched */
+        bool render(const std::vector<content_node *> &nodes) noexcept;
         /**
-         * write
+         * replace each file on disk whose bytes differ from the rendered one, an unchanged file keeps its mtime,
+         * files of the last commit that weren't rendered again are removed
          */
-        bool write(const std::vector<content_node *> &nodes)
+        bool commit() noexcept;
+        /** render and commit */
+        bool write(const std::vector<content_node *> &nodes) noexcept { return render(nodes) && commit(); }
+        /** render and commit the writers concurrently, false if any of them fails */
+        static bool write(const std::vector<writer *> &writers, const std::vector<content_node *> &nodes) noexcept;
+
+        /** files of the last render */
+        const std::vector<output_file> &files() const noexcept { return _files; }
+        /** the last commit changed any file */
+        bool written() const noexcept
         {
-            std::ofstream stream(path);
-            if (!stream)
-            {
-                _errors.push_back(path + ": open failed");
-                return false;
-            }
-            for (auto node : nodes)
+            for (auto &file : _files)
             {
-                auto type = node->type();
-                if (type == node_type::emodule)
-                {
-                    if (!write_emodule(stream, dynamic_cast<emodule_node *>(node)))
-                        return false;
-                }
-                else if (type == node_type::eenum)
-                {
-                    if (!write_eenum(stream, dynamic_cast<eenum_node *>(node)))
-                        return false;
-                }
-                else if (type == node_type::estruct)
-                {
-                    if (!write_estruct(stream, dynamic_cast<estruct_node *>(node)))
-                        return false;
-                }
+                if (file.written)
+                    return true;
             }
-            return true;
+            return false;
         }
-        /** errors */
+        /** errors of the last render and commit */
         const std::vector<std::string> &errors() const noexcept { return _errors; }
+        /** time the last render and commit took */
+        std::chrono::nanoseconds elapsed() const noexcept { return _time; }
 
     public:
         /** 
@@ -445,23 +1174,59 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
-    /** C++ program language */
+    /**
+     * C++ program language, structs encode and decode themselves;
+     * split, a header and a source for each module or declaration, a header of forward declarations,
+     * a header of the codec functions the sources use and a header including all headers at the path
+     */
     class cpp_writer : public writer
     {
+    private:
+        /** depth of the struct being written */
+        std::size_t _indent = 0;
+        /** encoded sizes of the structs written */
+        size_table _sizes;
+        /** std::pmr strings, arrays and maps, and structs constructed with an allocator */
+        bool _pmr = false;
+        /** qualified names of the structs, whose views are declared next to them */
+        std::unordered_set<std::string_view> _structs;
+
     public:
         using writer::writer;
 
+        /** write the types for decoding into an arena: std::pmr members and structs taking an allocator_type */
+        void pmr(bool enable) noexcept { _pmr = enable; }
+
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
+        bool write_files(const std::vector<content_node *> &nodes) noexcept override;
+
+    private:
+        /** name of the enum or struct in the global namespace */
+        std::string name(const content_node *node) const;
+        /** the name is free in C++ and in the generated code around the node, an error otherwise */
+        bool check_name(const content_node *node);
+        /** the comment of the node at the indent */
+        void write_comment(std::string &output, const content_node *node) const;
+        /** encode of the struct and the structs in it, a template of the sink defined out of the struct */
+        void write_encode(std::string &output, estruct_node *node) const;
+        /** decode of the struct and the structs in it, defined out of the struct */
+        void write_decode(std::string &output, estruct_node *node, const char *specifier) const;
+        /** constructors with an allocator of the struct and the structs in it in pmr mode, defined out of the struct */
+        void write_constructors(std::string &output, estruct_node *node, const char *specifier) const;
+        /** type the view of the struct reads the member type as */
+        std::string view_type(type_node *node);
+        /** members of the view of the struct and the structs in it, defined out of the view */
+        void write_view(std::string &output, estruct_node *node);
     };
 
     /** CSharp program language */
@@ -471,10 +1236,10 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
     /** Java program language */
@@ -484,10 +1249,10 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
     /** Go program language */
@@ -497,10 +1262,10 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
     /** Rust program language */
@@ -510,10 +1275,10 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
     /** Typescript program language */
@@ -523,10 +1288,10 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
     /** Python program language */
@@ -536,10 +1301,10 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 
     /** Lua program language */
@@ -549,9 +1314,9 @@ namespace anybuf
         using writer::writer;
 
     protected:
-        bool write_type(std::ofstream &stream, type_node *node) noexcept override;
-        bool write_emodule(std::ofstream &stream, emodule_node *node) noexcept override;
-        bool write_eenum(std::ofstream &stream, eenum_node *node) noexcept override;
-        bool write_estruct(std::ofstream &stream, estruct_node *node) noexcept override;
+        bool write_type(std::string &output, type_node *node) noexcept override;
+        bool write_emodule(std::string &output, emodule_node *node) noexcept override;
+        bool write_eenum(std::string &output, eenum_node *node) noexcept override;
+        bool write_estruct(std::string &output, estruct_node *node) noexcept override;
     };
 } // namespace anybuf
\ No newline at end of file
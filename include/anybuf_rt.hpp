@@ -0,0 +1,761 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** the host stores scalars in the little endian of the wire, arrays of them are copied in one block, 0 to loop */
+#ifndef ANYBUF_RT_LITTLE_ENDIAN
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define ANYBUF_RT_LITTLE_ENDIAN 1
+#else
+#define ANYBUF_RT_LITTLE_ENDIAN 0
+#endif
+#endif
+
+/**
+ * runtime of the generated C++ code: scalars in fixed width little endian, bool in 1 byte,
+ * str, array and map as a varint count and the elements, tuple as its elements, struct by its encode and decode
+ */
+namespace anybuf_rt
+{
+    /** a sink takes the encoded bytes by push_back(char) and append(const char *, std::size_t), std::string is one */
+    template <typename Sink, typename = void>
+    struct is_sink : std::false_type
+    {
+    };
+    template <typename Sink>
+    struct is_sink<Sink, std::void_t<decltype(std::declval<Sink &>().push_back(char())),
+                                     decltype(std::declval<Sink &>().append(std::declval<const char *>(), std::size_t()))>> : std::true_type
+    {
+    };
+    template <typename Sink>
+    inline constexpr bool is_sink_v = is_sink<Sink>::value;
+
+    /** sink writing into a buffer large enough for the value, max_encoded_size of a bounded struct, without checking */
+    class buffer_sink final
+    {
+    private:
+        char *_begin;
+        char *_end;
+
+    public:
+        explicit buffer_sink(char *buffer) noexcept : _begin(buffer), _end(buffer) {}
+
+        void push_back(char ch) noexcept { *_end++ = ch; }
+        void append(const char *data, std::size_t size) noexcept
+        {
+            std::memcpy(_end, data, size);
+            _end += size;
+        }
+
+        std::size_t size() const noexcept { return _end - _begin; }
+        std::string_view data() const noexcept { return std::string_view(_begin, size()); }
+    };
+    /** sink counting the bytes, to size a buffer before encoding into it */
+    class size_sink final
+    {
+    private:
+        std::size_t _size = 0;
+
+    public:
+        void push_back(char) noexcept { ++_size; }
+        void append(const char *, std::size_t size) noexcept { _size += size; }
+
+        std::size_t size() const noexcept { return _size; }
+    };
+
+    template <typename Sink>
+    inline void put_varint(Sink &out, std::uint64_t value)
+    {
+        char bytes[10];
+        std::size_t size = 0;
+        for (; value >= 0x80; value >>= 7)
+            bytes[size++] = static_cast<char>(value | 0x80);
+        bytes[size++] = static_cast<char>(value);
+        out.append(bytes, size);
+    }
+    inline bool get_varint(std::string_view &in, std::uint64_t &value)
+    {
+        value = 0;
+        for (std::size_t i = 0, shift = 0; i < in.size() && shift < 64; ++i, shift += 7)
+        {
+            auto byte = static_cast<std::uint8_t>(in[i]);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                in.remove_prefix(i + 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** decoder of the field of a struct at the index */
+    template <typename T>
+    struct field_decoder
+    {
+        std::uint8_t index;
+        bool (*decode)(T &value, std::string_view &in);
+    };
+    /** decoders of the fields of a struct by index, null for an unknown index */
+    template <typename T>
+    struct field_table
+    {
+        bool (*decoders[256])(T &value, std::string_view &in) = {};
+    };
+    template <typename T, std::size_t N>
+    constexpr field_table<T> make_field_table(const field_decoder<T> (&fields)[N]) noexcept
+    {
+        field_table<T> table;
+        for (std::size_t i = 0; i < N; ++i)
+            table.decoders[fields[i].index] = fields[i].decode;
+        return table;
+    }
+    /** take the index when the next field is the expected one, fields are encoded in index order */
+    inline bool next_field(std::string_view &in, std::uint64_t &count, std::uint8_t index) noexcept
+    {
+        if (count == 0 || in.size() == 0 || static_cast<std::uint8_t>(in[0]) != index)
+            return false;
+        in.remove_prefix(1);
+        --count;
+        return true;
+    }
+    /** the fields out of index order, each through the decoder of its index */
+    template <typename T>
+    bool get_fields(std::string_view &in, T &value, std::uint64_t count, const field_table<T> &table)
+    {
+        for (; count > 0; --count)
+        {
+            if (in.size() == 0)
+                return false;
+            auto decode = table.decoders[static_cast<std::uint8_t>(in[0])];
+            in.remove_prefix(1);
+            if (!decode || !decode(value, in))
+                return false;
+        }
+        return true;
+    }
+
+    /** an array of T is its elements' bytes as they are in memory, bool arrays are packed in memory and aren't */
+    template <typename T>
+    inline constexpr bool is_block_v = ANYBUF_RT_LITTLE_ENDIAN && (std::is_arithmetic_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, bool>;
+
+    template <typename T>
+    struct is_optional : std::false_type
+    {
+    };
+    template <typename T>
+    struct is_optional<std::optional<T>> : std::true_type
+    {
+    };
+    /**
+     * construct a T from the arguments with the allocator when T uses it, as the containers construct their elements,
+     * an optional holds a value made with the allocator
+     */
+    template <typename T, typename Alloc, typename... Args>
+    T make(const Alloc &allocator, Args &&...args)
+    {
+        if constexpr (is_optional<T>::value)
+        {
+            if constexpr (sizeof...(Args) == 0)
+                return T();
+            else
+            {
+                static_assert(sizeof...(Args) == 1, "an optional is made from another");
+                auto &&other = (args, ...);
+                if (!other)
+                    return T();
+                return T(std::in_place, make<typename T::value_type>(allocator, *std::forward<Args>(args)...));
+            }
+        }
+        else if constexpr (std::uses_allocator_v<T, Alloc> && std::is_constructible_v<T, std::allocator_arg_t, const Alloc &, Args...>)
+            return T(std::allocator_arg, allocator, std::forward<Args>(args)...);
+        else if constexpr (std::uses_allocator_v<T, Alloc> && std::is_constructible_v<T, Args..., const Alloc &>)
+            return T(std::forward<Args>(args)..., allocator);
+        else
+            return T(std::forward<Args>(args)...);
+    }
+    /** the value of the optional made with the allocator, for decoding into */
+    template <typename T, typename Alloc>
+    T &emplace(std::optional<T> &value, const Alloc &allocator)
+    {
+        return value.emplace(make<T>(allocator));
+    }
+    /**
+     * allocator of a generated struct in pmr mode, copied as pmr containers copy theirs:
+     * the default resource for a copy, the same resource for a move and never changed by an assignment
+     */
+    class pmr_allocator final
+    {
+    private:
+        std::pmr::polymorphic_allocator<char> _allocator;
+
+    public:
+        pmr_allocator() noexcept = default;
+        pmr_allocator(const std::pmr::polymorphic_allocator<char> &allocator) noexcept : _allocator(allocator) {}
+        pmr_allocator(const pmr_allocator &) noexcept {}
+        pmr_allocator(pmr_allocator &&other) noexcept : _allocator(other._allocator) {}
+        pmr_allocator &operator=(const pmr_allocator &) noexcept { return *this; }
+        pmr_allocator &operator=(pmr_allocator &&) noexcept { return *this; }
+
+        std::pmr::polymorphic_allocator<char> get() const noexcept { return _allocator; }
+    };
+    /** decode a struct generated in pmr mode with all of its memory from the resource, an arena freed in one go */
+    template <typename T>
+    std::optional<T> decode(std::string_view &in, std::pmr::memory_resource *resource)
+    {
+        std::optional<T> value(std::in_place, typename T::allocator_type(resource));
+        if (!value->decode(in))
+            return std::nullopt;
+        return value;
+    }
+
+    template <typename Sink, typename T>
+    auto put(Sink &out, const T &value) -> std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>;
+    template <typename Sink, typename T>
+    auto put(Sink &out, const T &value) -> decltype(value.encode(out));
+    template <typename Sink, typename A>
+    void put(Sink &out, const std::basic_string<char, std::char_traits<char>, A> &value);
+    template <typename Sink, typename T, typename A>
+    void put(Sink &out, const std::vector<T, A> &value);
+    template <typename Sink, typename... T>
+    void put(Sink &out, const std::tuple<T...> &value);
+    template <typename Sink, typename K, typename V, typename C, typename A>
+    void put(Sink &out, const std::map<K, V, C, A> &value);
+
+    template <typename T>
+    auto get(std::string_view &in, T &value) -> std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>, bool>;
+    template <typename T>
+    auto get(std::string_view &in, T &value) -> decltype(value.decode(in));
+    template <typename A>
+    bool get(std::string_view &in, std::basic_string<char, std::char_traits<char>, A> &value);
+    template <typename T, typename A>
+    bool get(std::string_view &in, std::vector<T, A> &value);
+    template <typename... T>
+    bool get(std::string_view &in, std::tuple<T...> &value);
+    template <typename K, typename V, typename C, typename A>
+    bool get(std::string_view &in, std::map<K, V, C, A> &value);
+
+    template <typename Sink, typename T>
+    auto put(Sink &out, const T &value) -> std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>
+    {
+        static_assert(is_sink_v<Sink>, "Sink should have push_back(char) and append(const char *, std::size_t)");
+        if constexpr (std::is_enum_v<T>)
+            put(out, static_cast<std::underlying_type_t<T>>(value));
+        else if constexpr (std::is_same_v<T, bool>)
+            out.push_back(value ? 1 : 0);
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            put(out, bits);
+        }
+        else
+        {
+            // one append of the bytes, a single store on little endian hosts
+            auto bits = static_cast<std::make_unsigned_t<T>>(value);
+            char bytes[sizeof(T)];
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+                bytes[i] = static_cast<char>(bits >> (i * 8));
+            out.append(bytes, sizeof(T));
+        }
+    }
+    template <typename Sink, typename T>
+    auto put(Sink &out, const T &value) -> decltype(value.encode(out))
+    {
+        value.encode(out);
+    }
+    template <typename Sink, typename A>
+    void put(Sink &out, const std::basic_string<char, std::char_traits<char>, A> &value)
+    {
+        put_varint(out, value.size());
+        out.append(value.data(), value.size());
+    }
+    template <typename Sink, typename T, typename A>
+    void put(Sink &out, const std::vector<T, A> &value)
+    {
+        put_varint(out, value.size());
+        if constexpr (is_block_v<T>)
+            out.append(reinterpret_cast<const char *>(value.data()), value.size() * sizeof(T));
+        else
+        {
+            for (const auto &element : value)
+                put(out, static_cast<const T &>(element));
+        }
+    }
+    template <typename Sink, typename... T>
+    void put(Sink &out, const std::tuple<T...> &value)
+    {
+        std::apply([&out](const auto &...element) { (put(out, element), ...); }, value);
+    }
+    template <typename Sink, typename K, typename V, typename C, typename A>
+    void put(Sink &out, const std::map<K, V, C, A> &value)
+    {
+        put_varint(out, value.size());
+        for (const auto &[key, element] : value)
+            put(out, key), put(out, element);
+    }
+
+    template <typename T>
+    auto get(std::string_view &in, T &value) -> std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>, bool>
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            std::underlying_type_t<T> raw;
+            if (!get(in, raw))
+                return false;
+            value = static_cast<T>(raw);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            if (in.size() == 0)
+                return false;
+            value = in[0] != 0;
+            in.remove_prefix(1);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> bits;
+            if (!get(in, bits))
+                return false;
+            std::memcpy(&value, &bits, sizeof(bits));
+        }
+        else
+        {
+            if (in.size() < sizeof(T))
+                return false;
+            std::make_unsigned_t<T> bits = 0;
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+                bits |= static_cast<std::make_unsigned_t<T>>(static_cast<std::uint8_t>(in[i])) << (i * 8);
+            value = static_cast<T>(bits);
+            in.remove_prefix(sizeof(T));
+        }
+        return true;
+    }
+    template <typename T>
+    auto get(std::string_view &in, T &value) -> decltype(value.decode(in))
+    {
+        return value.decode(in);
+    }
+    template <typename A>
+    bool get(std::string_view &in, std::basic_string<char, std::char_traits<char>, A> &value)
+    {
+        std::uint64_t size = 0;
+        if (!get_varint(in, size) || size > in.size())
+            return false;
+        value.assign(in.data(), size);
+        in.remove_prefix(size);
+        return true;
+    }
+    template <typename T, typename A>
+    bool get(std::string_view &in, std::vector<T, A> &value)
+    {
+        // every element takes a byte at least, scalars are copied as a block and the others constructed in place with the allocator of the array
+        std::uint64_t count = 0;
+        if (!get_varint(in, count) || count > in.size())
+            return false;
+        if constexpr (is_block_v<T>)
+        {
+            if (count * sizeof(T) > in.size())
+                return false;
+            value.resize(count);
+            if (count > 0)
+                std::memcpy(value.data(), in.data(), count * sizeof(T));
+            in.remove_prefix(count * sizeof(T));
+            return true;
+        }
+        value.clear();
+        value.reserve(count);
+        for (; count > 0; --count)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                bool element = false;
+                if (!get(in, element))
+                    return false;
+                value.push_back(element);
+            }
+            else if (!get(in, value.emplace_back()))
+                return false;
+        }
+        return true;
+    }
+    template <typename... T>
+    bool get(std::string_view &in, std::tuple<T...> &value)
+    {
+        return std::apply([&in](auto &...element) { return (get(in, element) && ...); }, value);
+    }
+    template <typename K, typename V, typename C, typename A>
+    bool get(std::string_view &in, std::map<K, V, C, A> &value)
+    {
+        std::uint64_t count = 0;
+        if (!get_varint(in, count) || count > in.size())
+            return false;
+        value.clear();
+        for (; count > 0; --count)
+        {
+            auto key = make<K>(value.get_allocator());
+            auto element = make<V>(value.get_allocator());
+            if (!get(in, key) || !get(in, element))
+                return false;
+            value.emplace(std::move(key), std::move(element));
+        }
+        return true;
+    }
+
+    /**
+     * skip and read in place of the value of a member type, the view reads T without materializing it:
+     * T for scalars and enums, std::string_view for str, array_view, tuple of views, map_view and the view of a struct
+     */
+    template <typename T, typename = void>
+    struct wire;
+    template <typename T>
+    using view_t = typename wire<T>::view;
+
+    /** elements of an encoded array, read as they are iterated */
+    template <typename T>
+    class array_view final
+    {
+    private:
+        std::string_view _data;
+        std::size_t _size = 0;
+
+    public:
+        class iterator final
+        {
+        private:
+            std::string_view _in;
+            std::size_t _left = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = view_t<T>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            iterator() noexcept = default;
+            iterator(std::string_view in, std::size_t left) noexcept : _in(in), _left(left) {}
+
+            value_type operator*() const noexcept
+            {
+                auto in = _in;
+                value_type value{};
+                wire<T>::read(in, value);
+                return value;
+            }
+            iterator &operator++() noexcept
+            {
+                wire<T>::skip(_in);
+                --_left;
+                return *this;
+            }
+            iterator operator++(int) noexcept
+            {
+                auto result = *this;
+                ++*this;
+                return result;
+            }
+            bool operator==(const iterator &other) const noexcept { return _left == other._left; }
+            bool operator!=(const iterator &other) const noexcept { return _left != other._left; }
+        };
+
+    public:
+        array_view() noexcept = default;
+        /** the elements checked by wire::skip */
+        array_view(std::string_view data, std::size_t size) noexcept : _data(data), _size(size) {}
+
+        std::size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+        iterator begin() const noexcept { return iterator(_data, _size); }
+        iterator end() const noexcept { return iterator(_data.substr(_data.size()), 0); }
+        /** constant time for scalars and enums, the elements before are skipped otherwise */
+        view_t<T> operator[](std::size_t index) const noexcept
+        {
+            auto in = _data;
+            if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+                in.remove_prefix(index * sizeof(T));
+            else
+            {
+                for (; index > 0; --index)
+                    wire<T>::skip(in);
+            }
+            view_t<T> value{};
+            wire<T>::read(in, value);
+            return value;
+        }
+    };
+    /** pairs of an encoded map, read as they are iterated */
+    template <typename K, typename V>
+    class map_view final
+    {
+    private:
+        std::string_view _data;
+        std::size_t _size = 0;
+
+    public:
+        class iterator final
+        {
+        private:
+            std::string_view _in;
+            std::size_t _left = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<view_t<K>, view_t<V>>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            iterator() noexcept = default;
+            iterator(std::string_view in, std::size_t left) noexcept : _in(in), _left(left) {}
+
+            value_type operator*() const noexcept
+            {
+                auto in = _in;
+                value_type value{};
+                wire<K>::read(in, value.first);
+                wire<V>::read(in, value.second);
+                return value;
+            }
+            iterator &operator++() noexcept
+            {
+                wire<K>::skip(_in);
+                wire<V>::skip(_in);
+                --_left;
+                return *this;
+            }
+            iterator operator++(int) noexcept
+            {
+                auto result = *this;
+                ++*this;
+                return result;
+            }
+            bool operator==(const iterator &other) const noexcept { return _left == other._left; }
+            bool operator!=(const iterator &other) const noexcept { return _left != other._left; }
+        };
+
+    public:
+        map_view() noexcept = default;
+        /** the pairs checked by wire::skip */
+        map_view(std::string_view data, std::size_t size) noexcept : _data(data), _size(size) {}
+
+        std::size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+        iterator begin() const noexcept { return iterator(_data, _size); }
+        iterator end() const noexcept { return iterator(_data.substr(_data.size()), 0); }
+        /** the value of the key, by a linear scan of the pairs */
+        template <typename Key>
+        std::optional<view_t<V>> find(const Key &key) const noexcept
+        {
+            for (auto [first, second] : *this)
+            {
+                if (first == key)
+                    return second;
+            }
+            return std::nullopt;
+        }
+    };
+
+    template <typename T>
+    struct wire<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>>
+    {
+        using view = T;
+        static bool skip(std::string_view &in) noexcept
+        {
+            if (in.size() < sizeof(T))
+                return false;
+            in.remove_prefix(sizeof(T));
+            return true;
+        }
+        static bool read(std::string_view &in, view &value) noexcept { return get(in, value); }
+    };
+    template <typename A>
+    struct wire<std::basic_string<char, std::char_traits<char>, A>>
+    {
+        using view = std::string_view;
+        static bool skip(std::string_view &in) noexcept
+        {
+            view value;
+            return read(in, value);
+        }
+        static bool read(std::string_view &in, view &value) noexcept
+        {
+            std::uint64_t size = 0;
+            if (!get_varint(in, size) || size > in.size())
+                return false;
+            value = in.substr(0, size);
+            in.remove_prefix(size);
+            return true;
+        }
+    };
+    template <typename T, typename A>
+    struct wire<std::vector<T, A>>
+    {
+        using view = array_view<T>;
+        static bool skip(std::string_view &in) noexcept
+        {
+            view value;
+            return read(in, value);
+        }
+        static bool read(std::string_view &in, view &value) noexcept
+        {
+            // every element takes a byte at least, scalars and enums a fixed size
+            std::uint64_t count = 0;
+            if (!get_varint(in, count) || count > in.size())
+                return false;
+            auto data = in;
+            if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            {
+                if (count * sizeof(T) > in.size())
+                    return false;
+                in.remove_prefix(count * sizeof(T));
+            }
+            else
+            {
+                for (auto left = count; left > 0; --left)
+                {
+                    if (!wire<T>::skip(in))
+                        return false;
+                }
+            }
+            value = view(data.substr(0, data.size() - in.size()), count);
+            return true;
+        }
+    };
+    template <typename... T>
+    struct wire<std::tuple<T...>>
+    {
+        using view = std::tuple<view_t<T>...>;
+        static bool skip(std::string_view &in) noexcept { return (wire<T>::skip(in) && ...); }
+        static bool read(std::string_view &in, view &value) noexcept
+        {
+            return std::apply([&in](auto &...element) { return (wire<T>::read(in, element) && ...); }, value);
+        }
+    };
+    template <typename K, typename V, typename C, typename A>
+    struct wire<std::map<K, V, C, A>>
+    {
+        using view = map_view<K, V>;
+        static bool skip(std::string_view &in) noexcept
+        {
+            view value;
+            return read(in, value);
+        }
+        static bool read(std::string_view &in, view &value) noexcept
+        {
+            std::uint64_t count = 0;
+            if (!get_varint(in, count) || count > in.size())
+                return false;
+            auto data = in;
+            for (auto left = count; left > 0; --left)
+            {
+                if (!wire<K>::skip(in) || !wire<V>::skip(in))
+                    return false;
+            }
+            value = view(data.substr(0, data.size() - in.size()), count);
+            return true;
+        }
+    };
+    /** state of the generated views, kept out of the names of their accessors, which are the fields */
+    struct view_access
+    {
+        template <typename View>
+        static auto size(const View &view) noexcept -> decltype(view.anybuf_size) { return view.anybuf_size; }
+        template <typename View>
+        static bool skip(std::string_view &in) noexcept { return View::anybuf_skip(in); }
+    };
+    /** the view read a whole struct, with its bases and fields checked */
+    template <typename View>
+    auto valid(const View &view) noexcept -> decltype(view_access::size(view) > 0) { return view_access::size(view) > 0; }
+    /** bytes of the struct the view read, 0 unless it is valid */
+    template <typename View>
+    auto size(const View &view) noexcept -> decltype(view_access::size(view)) { return view_access::size(view); }
+
+    /** a struct by its generated view, which checks the struct as it is constructed */
+    template <typename T>
+    struct wire<T, std::void_t<typename T::anybuf_view>>
+    {
+        using view = typename T::anybuf_view;
+        static bool skip(std::string_view &in) noexcept { return view_access::skip<view>(in); }
+        static bool read(std::string_view &in, view &value) noexcept
+        {
+            value = view(in);
+            if (view_access::size(value) == 0)
+                return false;
+            in.remove_prefix(view_access::size(value));
+            return true;
+        }
+    };
+
+    /** skipper of the field of a struct at the index */
+    struct field_skipper
+    {
+        std::uint8_t index;
+        bool (*skip)(std::string_view &in);
+    };
+    /** skippers of the fields of a struct by index, null for an unknown index */
+    struct skip_table
+    {
+        bool (*skips[256])(std::string_view &in) = {};
+    };
+    template <std::size_t N>
+    constexpr skip_table make_skip_table(const field_skipper (&fields)[N]) noexcept
+    {
+        skip_table table;
+        for (std::size_t i = 0; i < N; ++i)
+            table.skips[fields[i].index] = fields[i].skip;
+        return table;
+    }
+    /** skip the field count and the fields of a struct, false on an unknown index or a short input */
+    inline bool skip_fields(std::string_view &in, const skip_table &table) noexcept
+    {
+        std::uint64_t count = 0;
+        if (!get_varint(in, count))
+            return false;
+        for (; count > 0; --count)
+        {
+            if (in.size() == 0)
+                return false;
+            auto skip = table.skips[static_cast<std::uint8_t>(in[0])];
+            in.remove_prefix(1);
+            if (!skip || !skip(in))
+                return false;
+        }
+        return true;
+    }
+    /** the field at the index in the fields checked by skip_fields, read in place, empty when absent */
+    template <typename T>
+    std::optional<view_t<T>> field(std::string_view fields, std::uint8_t index, const skip_table &table) noexcept
+    {
+        std::uint64_t count = 0;
+        if (!get_varint(fields, count))
+            return std::nullopt;
+        for (; count > 0 && fields.size() > 0; --count)
+        {
+            auto at = static_cast<std::uint8_t>(fields[0]);
+            fields.remove_prefix(1);
+            if (at == index)
+            {
+                view_t<T> value{};
+                if (!wire<T>::read(fields, value))
+                    return std::nullopt;
+                return value;
+            }
+            auto skip = table.skips[at];
+            if (!skip || !skip(fields))
+                return std::nullopt;
+        }
+        return std::nullopt;
+    }
+} // namespace anybuf_rt
@@ -1,77 +1,676 @@
+#include <algorithm>
+#include <bitset>
 #include <filesystem>
 #include <iterator>
+#include <set>
+#include <thread>
+#include <unordered_set>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
 
 #include "anybuf.hpp"
 
+/** build of the compiler, a release may define it to its version to share the cache entries across its builds */
+#ifndef ANYBUF_BUILD
+#define ANYBUF_BUILD __DATE__ " " __TIME__
+#endif
+
 namespace anybuf
 {
-    void reader::scan(const std::string &path) noexcept
+    std::vector<estruct_node *> direct_bases(const estruct_node *node)
     {
-        auto file = std::ifstream(path);
-        auto data = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        // ancestors of the bases, each struct visited once
+        std::unordered_set<const estruct_node *> ancestors;
+        std::vector<const estruct_node *> stack;
+        for (auto base : node->bases)
+            stack.insert(stack.end(), base->bases.begin(), base->bases.end());
+        while (stack.size() > 0)
+        {
+            auto ancestor = stack.back();
+            stack.pop_back();
+            if (ancestors.insert(ancestor).second)
+                stack.insert(stack.end(), ancestor->bases.begin(), ancestor->bases.end());
+        }
 
-        auto &src = _sources[path];
-        decltype(data.size()) tpos = std::string::npos, trow = 1, tcol = 1, flag = 0 /** 1:line comment, 2:block comment, 3:string */;
-        for (decltype(data.size()) pos = 0, size = data.size(), row = 1, col = 1; pos < size; ++pos, ++col)
+        std::vector<estruct_node *> bases;
+        for (auto base : node->bases)
         {
-            auto ch = data[pos];
-            if (tpos == std::string::npos && ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')
-                tpos = pos, trow = row, tcol = col;
+            if (ancestors.count(base) == 0 && std::find(bases.begin(), bases.end(), base) == bases.end())
+                bases.push_back(base);
+        }
+        return bases;
+    }
+
+    encoded_size size_table::size(const estruct_node *node) noexcept
+    {
+        if (auto iter = _sizes.find(node); iter != _sizes.end())
+            return iter->second;
+        // a struct reached again while it is computed holds itself
+        _sizes[node] = encoded_size{1, 0, false};
+
+        encoded_size result{0, 0, true};
+        auto add = [&result](const encoded_size &size) {
+            result.min += size.min, result.max += size.max;
+            result.bounded = result.bounded && size.bounded;
+        };
+        for (auto base : direct_bases(node))
+            add(size(base));
+
+        // the count of the present fields is a varint, 2 bytes from 128
+        std::size_t fields = 0, required = 0;
+        for (auto member : node->members)
+        {
+            if (member->type() != node_type::estruct_member)
+                continue;
+            auto field = static_cast<const estruct_member_node *>(member);
+            auto value = size(field->format);
+            ++fields, required += field->optional ? 0 : 1;
+            add(encoded_size{field->optional ? 0 : 1 + value.min, 1 + value.max, value.bounded});
+        }
+        add(encoded_size{required < 128 ? 1u : 2u, fields < 128 ? 1u : 2u, true});
+        return _sizes[node] = result;
+    }
+    encoded_size size_table::size(const type_node *node) noexcept
+    {
+        switch (node->format)
+        {
+        case identity::i8:
+        case identity::u8:
+        case identity::boolean:
+            return encoded_size{1, 1, true};
+        case identity::i16:
+        case identity::u16:
+            return encoded_size{2, 2, true};
+        case identity::i32:
+        case identity::u32:
+        case identity::f32:
+            return encoded_size{4, 4, true};
+        case identity::i64:
+        case identity::u64:
+        case identity::f64:
+            return encoded_size{8, 8, true};
+        case identity::eenum:
+            switch (static_cast<const eenum_node *>(node->values[0])->format)
+            {
+            case identity::i8:
+            case identity::u8:
+                return encoded_size{1, 1, true};
+            case identity::i16:
+            case identity::u16:
+                return encoded_size{2, 2, true};
+            case identity::i64:
+            case identity::u64:
+                return encoded_size{8, 8, true};
+            default:
+                return encoded_size{4, 4, true};
+            }
+        case identity::estruct:
+            return size(static_cast<const estruct_node *>(node->values[0]));
+        case identity::tuple:
+        {
+            encoded_size result{0, 0, true};
+            for (auto value : node->values)
+            {
+                auto element = size(static_cast<const type_node *>(value));
+                result.min += element.min, result.max += element.max;
+                result.bounded = result.bounded && element.bounded;
+            }
+            return result;
+        }
+        default:
+            // str, array and map, a varint count and as many elements as it says
+            return encoded_size{1, 0, false};
+        }
+    }
 
-            if (tpos != std::string::npos && (pos == size - 1 || !((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '_')))
+    bool mapping::open(const std::string &path) noexcept
+    {
+        close();
+#ifdef WIN32
+        auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER size;
+            if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
             {
-                decltype(tpos) tend = std::string::npos;
-                if (pos < size - 1)
+                if (auto map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr); map)
                 {
-                    if (pos == tpos)
+                    if (auto data = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0); data)
                     {
-                        if (ch == '/' && (data[pos + 1] == '/' || data[pos + 1] == '*'))
-                            flag = data[++pos] == '/' ? 1 : 2, ++col;
-                        else if (ch == '"')
-                            flag = 3;
-                        else
-                            tend = pos;
+                        _file = file, _map = map;
+                        _data = static_cast<const char *>(data), _size = static_cast<std::size_t>(size.QuadPart);
+                        return true;
                     }
-                    else if (flag == 1)
-                    {
-                        if (ch == '\r' || ch == '\n')
-                            tend = pos - 1;
-                    }
-                    else if (flag == 2)
-                    {
-                        if (ch == '*' && data[pos + 1] == '/')
-                            ++col, tend = ++pos;
-                    }
-                    else if (flag == 3)
+                    CloseHandle(map);
+                }
+            }
+            CloseHandle(file);
+        }
+#else
+        if (auto fd = ::open(path.c_str(), O_RDONLY); fd != -1)
+        {
+            struct stat status;
+            if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+            {
+                if (auto data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED)
+                {
+                    ::close(fd);
+                    _data = static_cast<const char *>(data), _size = static_cast<std::size_t>(status.st_size);
+                    return true;
+                }
+            }
+            ::close(fd);
+        }
+#endif
+
+        // empty or unmappable file, fall back to reading it
+        auto file = std::ifstream(path, std::ios::binary);
+        if (!file)
+            return false;
+        auto data = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (data.size() > 0)
+        {
+            _buffer = std::make_unique<char[]>(data.size());
+            data.copy(_buffer.get(), data.size());
+        }
+        _data = _buffer.get(), _size = data.size();
+        return true;
+    }
+    void mapping::close() noexcept
+    {
+        if (_data && !_buffer)
+        {
+#ifdef WIN32
+            UnmapViewOfFile(_data);
+            CloseHandle(_map);
+            CloseHandle(_file);
+            _file = _map = nullptr;
+#else
+            munmap(const_cast<char *>(_data), _size);
+#endif
+        }
+        _buffer.reset();
+        _data = nullptr, _size = 0;
+    }
+
+    namespace
+    {
+        inline int trailing_zeros(uint64_t bits) noexcept
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, bits);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctzll(bits);
+#endif
+        }
+        inline int leading_zeros(uint64_t bits) noexcept
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, bits);
+            return 63 - static_cast<int>(index);
+#else
+            return __builtin_clzll(bits);
+#endif
+        }
+        inline int popcount(uint64_t bits) noexcept
+        {
+#ifdef _MSC_VER
+            return static_cast<int>(__popcnt64(bits));
+#else
+            return __builtin_popcountll(bits);
+#endif
+        }
+
+        /**
+         * structural index of a source, one bit per byte for every 64 bytes block
+         * the masks are built 16 (SSE2) or 32 (AVX2) bytes per step, scalar on other targets
+         */
+        class scan_index
+        {
+        public:
+            struct block
+            {
+                /** A-Z a-z 0-9 _ */
+                uint64_t ident;
+                /** ' ' \t \r \n */
+                uint64_t space;
+                /** \r \n */
+                uint64_t eol;
+                /** line breaks: \n, and \r not followed by \n */
+                uint64_t line;
+                /** " \ */
+                uint64_t string;
+                /** '*' followed by '/' */
+                uint64_t close;
+            };
+
+        private:
+            struct masks
+            {
+                uint64_t ident = 0, space = 0, cr = 0, lf = 0, string = 0, star = 0, slash = 0;
+            };
+
+            std::vector<block> _blocks;
+            std::size_t _size;
+
+        private:
+            static masks classify(const char *data) noexcept
+            {
+                masks masks;
+#if defined(__AVX2__)
+                for (int i = 0; i < 64; i += 32)
+                {
+                    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                    auto lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+                    auto alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+                    auto digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+                    auto ident = _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+                    auto cr = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'));
+                    auto lf = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+                    auto blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+                    auto string = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+
+                    masks.ident |= uint64_t(uint32_t(_mm256_movemask_epi8(ident))) << i;
+                    masks.space |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_or_si256(blank, _mm256_or_si256(cr, lf))))) << i;
+                    masks.cr |= uint64_t(uint32_t(_mm256_movemask_epi8(cr))) << i;
+                    masks.lf |= uint64_t(uint32_t(_mm256_movemask_epi8(lf))) << i;
+                    masks.string |= uint64_t(uint32_t(_mm256_movemask_epi8(string))) << i;
+                    masks.star |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('*'))))) << i;
+                    masks.slash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'))))) << i;
+                }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+                for (int i = 0; i < 64; i += 16)
+                {
+                    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                    auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+                    auto alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+                    auto digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+                    auto ident = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+                    auto cr = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+                    auto lf = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+                    auto blank = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+                    auto string = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+
+                    masks.ident |= uint64_t(_mm_movemask_epi8(ident)) << i;
+                    masks.space |= uint64_t(_mm_movemask_epi8(_mm_or_si128(blank, _mm_or_si128(cr, lf)))) << i;
+                    masks.cr |= uint64_t(_mm_movemask_epi8(cr)) << i;
+                    masks.lf |= uint64_t(_mm_movemask_epi8(lf)) << i;
+                    masks.string |= uint64_t(_mm_movemask_epi8(string)) << i;
+                    masks.star |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('*')))) << i;
+                    masks.slash |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')))) << i;
+                }
+#else
+                for (int i = 0; i < 64; ++i)
+                {
+                    auto ch = data[i];
+                    auto bit = uint64_t(1) << i;
+                    if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '_')
+                        masks.ident |= bit;
+                    if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+                        masks.space |= bit;
+                    if (ch == '\r')
+                        masks.cr |= bit;
+                    if (ch == '\n')
+                        masks.lf |= bit;
+                    if (ch == '"' || ch == '\\')
+                        masks.string |= bit;
+                    if (ch == '*')
+                        masks.star |= bit;
+                    if (ch == '/')
+                        masks.slash |= bit;
+                }
+#endif
+                return masks;
+            }
+            static masks classify(const char *data, std::size_t size) noexcept
+            {
+                if (size >= 64)
+                    return classify(data);
+
+                // the tail is padded with '\0', which belongs to no class
+                char block[64] = {};
+                std::copy(data, data + size, block);
+                return classify(block);
+            }
+
+        public:
+            explicit scan_index(std::string_view data) : _blocks((data.size() + 63) / 64), _size(data.size())
+            {
+                if (_blocks.empty())
+                    return;
+
+                auto curr = classify(data.data(), data.size());
+                for (std::size_t i = 0, size = _blocks.size(); i < size; ++i)
+                {
+                    auto next = i + 1 < size ? classify(data.data() + (i + 1) * 64, data.size() - (i + 1) * 64) : masks();
+                    _blocks[i] = block{
+                        curr.ident,
+                        curr.space,
+                        curr.cr | curr.lf,
+                        curr.lf | (curr.cr & ~((curr.lf >> 1) | (next.lf << 63))),
+                        curr.string,
+                        curr.star & ((curr.slash >> 1) | (next.slash << 63)),
+                    };
+                    curr = next;
+                }
+            }
+
+            /** the first position from pos whose bit in mask equals value, or size */
+            std::size_t find(std::size_t pos, uint64_t block::*mask, bool value) const noexcept
+            {
+                for (std::size_t i = pos / 64, size = _blocks.size(); i < size; ++i)
+                {
+                    auto bits = value ? _blocks[i].*mask : ~(_blocks[i].*mask);
+                    if (i == pos / 64)
+                        bits &= ~uint64_t(0) << (pos % 64);
+                    if (bits)
+                        return std::min(_size, i * 64 + trailing_zeros(bits));
+                }
+                return _size;
+            }
+            /** count the line breaks in [begin, end), last is set to the position of the final one */
+            std::size_t lines(std::size_t begin, std::size_t end, std::size_t &last) const noexcept
+            {
+                std::size_t count = 0;
+                for (std::size_t i = begin / 64; i * 64 < end; ++i)
+                {
+                    auto bits = _blocks[i].line;
+                    if (i == begin / 64)
+                        bits &= ~uint64_t(0) << (begin % 64);
+                    if (end - i * 64 < 64)
+                        bits &= ~(~uint64_t(0) << (end - i * 64));
+                    if (bits)
                     {
-                        if (ch == '\\')
-                            ++pos, ++col;
-                        else if (ch == '"')
-                            tend = pos;
+                        count += popcount(bits);
+                        last = i * 64 + 63 - leading_zeros(bits);
                     }
-                    else
+                }
+                return count;
+            }
+            /** an escaped line break inside a string doesn't start a new line */
+            void escape(std::size_t pos) noexcept { _blocks[pos / 64].line &= ~(uint64_t(1) << (pos % 64)); }
+        };
+
+        /** runs a batch of tasks on threads, a worker out of tasks steals half of the tasks left to another */
+        class work_pool
+        {
+        private:
+            /** tasks [begin, end) of a worker */
+            struct queue
+            {
+                std::mutex lock;
+                std::size_t begin = 0;
+                std::size_t end = 0;
+            };
+
+        public:
+            static std::size_t concurrency() noexcept
+            {
+                auto count = std::thread::hardware_concurrency();
+                return count > 0 ? count : 1;
+            }
+
+            /** call task(index, worker) for each index below count, worker is below concurrency() */
+            template <typename Task>
+            static void run(std::size_t count, Task &&task)
+            {
+                auto workers = std::min(concurrency(), count);
+                if (workers <= 1)
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                        task(i, std::size_t(0));
+                    return;
+                }
+
+                std::vector<queue> queues(workers);
+                for (std::size_t i = 0; i < workers; ++i)
+                    queues[i].begin = count * i / workers, queues[i].end = count * (i + 1) / workers;
+
+                auto work = [&](std::size_t worker) {
+                    auto &own = queues[worker];
+                    while (true)
                     {
-                        tend = pos - 1;
-                        if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')
-                            --pos, --col;
+                        std::size_t index = count;
+                        {
+                            std::lock_guard lock(own.lock);
+                            if (own.begin < own.end)
+                                index = own.begin++;
+                        }
+                        for (std::size_t i = 1; index == count && i < workers; ++i)
+                        {
+                            auto &other = queues[(worker + i) % workers];
+                            std::scoped_lock lock(own.lock, other.lock);
+                            if (other.begin < other.end)
+                            {
+                                auto middle = other.begin + (other.end - other.begin) / 2;
+                                index = middle;
+                                own.begin = middle + 1, own.end = other.end;
+                                other.end = middle;
+                            }
+                        }
+                        if (index == count)
+                            return;
+                        task(index, worker);
                     }
-                }
+                };
+
+                std::vector<std::thread> threads;
+                for (std::size_t i = 1; i < workers; ++i)
+                    threads.emplace_back(work, i);
+                work(0);
+                for (auto &thread : threads)
+                    thread.join();
+            }
+        };
+
+        /** absolute path of the file imported by a source, or empty if the file doesn't exist */
+        std::string import_path(const std::string &path, std::string_view text)
+        {
+            std::filesystem::path import_path(text.substr(1, text.size() - 2));
+            if (import_path.is_relative())
+                import_path = std::filesystem::path(path).replace_filename(import_path).lexically_normal();
+            if (!import_path.is_absolute() || !std::filesystem::is_regular_file(import_path))
+                return std::string();
+            return import_path.lexically_normal().string();
+        }
+
+        /** adds the time from its construction to its destruction to the total, if there's one */
+        class stopwatch final
+        {
+        private:
+            std::chrono::nanoseconds *_total;
+            std::chrono::steady_clock::time_point _start;
+
+        public:
+            explicit stopwatch(std::chrono::nanoseconds *total) noexcept : _total(total)
+            {
+                if (_total)
+                    _start = std::chrono::steady_clock::now();
+            }
+            stopwatch(const stopwatch &) = delete;
+            stopwatch &operator=(const stopwatch &) = delete;
+            ~stopwatch() noexcept
+            {
+                if (_total)
+                    *_total += std::chrono::steady_clock::now() - _start;
+            }
+        };
+
+        /** FNV-1a */
+        std::uint64_t fnv1a(std::string_view data, std::uint64_t hash = 14695981039346656037ull) noexcept
+        {
+            for (auto ch : data)
+                hash = (hash ^ static_cast<unsigned char>(ch)) * 1099511628211ull;
+            return hash;
+        }
+        /** key of the compiler in the cache entries, another build may read the same source differently */
+        const std::uint64_t cache_build = fnv1a(ANYBUF_BUILD);
+        /** file of the cache entry of the source */
+        std::filesystem::path cache_path(const std::string &cache, const std::string &path)
+        {
+            auto hash = fnv1a(path);
+            std::string name(16, '0');
+            for (auto i = name.size(); i > 0; --i, hash >>= 4)
+                name[i - 1] = "0123456789abcdef"[hash & 15];
+            return std::filesystem::path(cache) / (name + ".cache");
+        }
+
+        /** appends values to a cache entry in the byte order of the machine */
+        class cache_output
+        {
+        private:
+            std::string &_data;
+
+        public:
+            explicit cache_output(std::string &data) noexcept : _data(data) {}
+
+            template <typename T>
+            void put(T value)
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "T should be trivially copyable");
+                _data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+            }
+            void put(std::string_view text)
+            {
+                put(static_cast<std::uint32_t>(text.size()));
+                _data.append(text);
+            }
+        };
+        /** reads values of a cache entry, a read past the end fails the input */
+        class cache_input
+        {
+        private:
+            std::string_view _data;
+            std::size_t _pos = 0;
+            bool _good = true;
 
-                if (tend != std::string::npos || pos == size - 1)
+        public:
+            explicit cache_input(std::string_view data) noexcept : _data(data) {}
+
+            bool good() const noexcept { return _good; }
+            template <typename T>
+            T get() noexcept
+            {
+                T value{};
+                if (_good = _good && _data.size() - _pos >= sizeof(T); _good)
                 {
-                    src.tokens.push_back(token(trow, tcol, data.substr(tpos, tend - tpos + 1)));
-                    tpos = std::string::npos, flag = 0;
+                    std::copy_n(_data.data() + _pos, sizeof(T), reinterpret_cast<char *>(&value));
+                    _pos += sizeof(T);
                 }
+                return value;
+            }
+            std::string_view text() noexcept
+            {
+                auto size = get<std::uint32_t>();
+                if (_good = _good && _data.size() - _pos >= size; !_good)
+                    return std::string_view();
+                _pos += size;
+                return _data.substr(_pos - size, size);
+            }
+        };
+    } // namespace
+
+    reader::source &reader::add(const std::string &path)
+    {
+        auto [iter, inserted] = _sources.try_emplace(path);
+        auto &src = iter->second;
+        if (inserted)
+        {
+            src.file = static_cast<std::uint32_t>(_files.size());
+            src.symbols.shared = &_symbols;
+            _files.push_back(path);
+        }
+        return src;
+    }
+    void reader::scan(source &src) noexcept
+    {
+        stopwatch watch(_measure ? &src.scan_time : nullptr);
+        src.tokens.clear();
+        auto data = src.content.data();
+        auto size = data.size();
+        auto index = scan_index(data);
+
+        // row and col of the token starting at pos, counted lazily from the line breaks index
+        std::size_t row = 1, line = 0, counted = 0;
+        auto push = [&](std::size_t pos, std::size_t end) {
+            std::size_t last = 0;
+            if (auto count = index.lines(counted, pos, last); count > 0)
+                row += count, line = last + 1;
+            counted = pos;
+            src.tokens.emplace_back(row, pos - line + 1, data.substr(pos, end - pos));
+        };
+
+        for (std::size_t pos = index.find(0, &scan_index::block::space, false); pos < size; pos = index.find(pos, &scan_index::block::space, false))
+        {
+            auto ch = data[pos];
+            if (pos == size - 1)
+            {
+                push(pos, size);
+                break;
             }
 
-            // \n - UNIX   \r\n - DOS   \r - Mac
-            if (ch == '\r' || ch == '\n')
+            std::size_t end = size;
+            if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || ch == '_')
+            {
+                // a token reaching the last character takes the rest of the source
+                if (end = index.find(pos, &scan_index::block::ident, false); end >= size - 1)
+                    end = size;
+            }
+            else if (ch == '/' && data[pos + 1] == '/')
+            {
+                if (end = pos + 1 < size - 1 ? index.find(pos + 2, &scan_index::block::eol, true) : size; end >= size - 1)
+                    end = size;
+            }
+            else if (ch == '/' && data[pos + 1] == '*')
+            {
+                if (end = pos + 1 < size - 1 ? index.find(pos + 2, &scan_index::block::close, true) : size; end >= size - 1)
+                    end = size;
+                else
+                    end += 2;
+            }
+            else if (ch == '"')
             {
-                row++;
-                col = 0;
-                if (ch == '\r' && pos + 1 < size && data[pos + 1] == '\n')
-                    pos++;
+                for (end = index.find(pos + 1, &scan_index::block::string, true); end < size - 1; end = index.find(end + 2, &scan_index::block::string, true))
+                {
+                    if (data[end] == '"')
+                        break;
+                    // \ skips the next character
+                    index.escape(end + 1);
+                    if (end + 1 == size - 1)
+                        break;
+                }
+                end = end < size - 1 && data[end] == '"' ? end + 1 : size;
             }
+            else
+                end = pos + 1;
+
+            push(pos, end);
+            if (end >= size)
+                break;
+            pos = end;
         }
     }
 
@@ -90,12 +689,12 @@ namespace anybuf
         read_comment(context);
         if (context.eof())
         {
-            _errors.push_back(context.error(context.size - 1, "error at end"));
+            context.src.errors.push_back(context.error(context.size - 1, "error at end"));
             return false;
         }
         else if (where && !where(context.curr()))
         {
-            _errors.push_back(context.error(desc));
+            context.src.errors.push_back(context.error(desc));
             return false;
         }
         return true;
@@ -124,7 +723,7 @@ namespace anybuf
                     value = value * 16 + nx + 10;
                 else
                 {
-                    _errors.push_back(context.error("invalid integer"));
+                    context.src.errors.push_back(context.error("invalid integer"));
                     return false;
                 }
             }
@@ -132,260 +731,292 @@ namespace anybuf
         ++context;
         return true;
     }
-    content_node *reader::read_scopes(context &context, const std::vector<std::size_t> &names, bool upward) const
+    void *node_arena::allocate(std::size_t size, std::size_t align)
     {
-        for (std::size_t size = context.scopes.size(), i = size; i <= size; --i)
+        while (_chunk < _chunks.size())
         {
-            std::vector<content_node *> nodes; // module, struct
-            if (i == 0)
-                nodes = _nodes;
-            else
+            auto &chunk = _chunks[_chunk];
+            auto offset = (_offset + align - 1) & ~(align - 1);
+            if (offset + size <= chunk.size)
             {
-                if (auto node = context.scopes[i - 1]; node->type() == node_type::emodule)
-                {
-                    struct emodule_searcher
-                    {
-                        std::vector<content_node *> path;
-                        std::vector<emodule_node *> modules;
-                        emodule_searcher(emodule_node *node)
-                        {
-                            path.push_back(node);
-                            for (auto parent = node->parent; parent; parent = parent->parent)
-                                path.insert(path.begin(), parent);
-                        }
-                        void search(std::vector<content_node *> nodes, std::size_t index = 0)
-                        {
-                            for (auto node : nodes)
-                            {
-                                if (node->type() == node_type::emodule && node->name == path[index]->name)
-                                {
-                                    if (index >= path.size() - 1)
-                                    {
-                                        modules.push_back(dynamic_cast<emodule_node *>(node));
-                                    }
-                                    else
-                                    {
-                                        search(dynamic_cast<emodule_node *>(node)->members, ++index);
-                                    }
-                                }
-                            }
-                        }
-                    };
-                    auto searcher = emodule_searcher(dynamic_cast<emodule_node *>(node));
-                    searcher.search(_nodes);
-
-                    for (auto node : searcher.modules)
-                    {
-                        for (auto member : node->members)
-                            nodes.push_back(member);
-                    }
-                }
-                else
-                {
-                    for (auto member : dynamic_cast<estruct_node *>(node)->members)
-                    {
-                        if (member->type() != node_type::estruct_member)
-                            nodes.push_back(member);
-                    }
-                }
+                _offset = offset + size;
+                return chunk.data.get() + offset;
             }
+            ++_chunk, _offset = 0;
+        }
 
-            for (auto node : nodes)
-            {
-                std::vector<content_node *> sub_nodes = {node};
-                std::size_t i = 0;
-                for (auto node : sub_nodes)
-                {
-                    while (i < names.size())
-                    {
-                        if (context[names[i]].text != node->name)
-                            break;
-                        else
-                        {
-                            if (i == names.size() - 1)
-                                return node;
-
-                            if (node->type() == node_type::emodule)
-                                sub_nodes = dynamic_cast<emodule_node *>(node)->members;
-                            if (node->type() == node_type::estruct)
-                                sub_nodes = dynamic_cast<estruct_node *>(node)->members;
-                            ++i;
-                        }
-                    }
-                }
-            }
+        auto chunk_size = std::max(size, node_arena::chunk_size);
+        _chunks.push_back(chunk{std::make_unique<unsigned char[]>(chunk_size), chunk_size});
+        _chunk = _chunks.size() - 1, _offset = size;
+        return _chunks[_chunk].data.get();
+    }
+    void node_arena::clear() noexcept
+    {
+        for (auto i = _nodes.size(); i > 0; --i)
+            _nodes[i - 1]->~node();
+        _nodes.clear();
+        _chunk = 0, _offset = 0;
+    }
+    std::size_t node_arena::capacity() const noexcept
+    {
+        std::size_t size = 0;
+        for (auto &chunk : _chunks)
+            size += chunk.size;
+        return size;
+    }
+
+    std::string_view string_pool::copy(std::string_view text)
+    {
+        while (_chunk < _chunks.size() && _offset + text.size() > _chunks[_chunk].size)
+            ++_chunk, _offset = 0;
+        if (_chunk == _chunks.size())
+        {
+            auto size = std::max(text.size(), chunk_size);
+            _chunks.push_back(chunk{std::make_unique<char[]>(size), size});
+        }
+
+        auto data = _chunks[_chunk].data.get() + _offset;
+        text.copy(data, text.size());
+        _offset += text.size();
+        return std::string_view(data, text.size());
+    }
+    std::string_view string_pool::store(std::string_view text)
+    {
+        std::lock_guard lock(_lock);
+        return copy(text);
+    }
+    std::string_view string_pool::intern(std::string_view text)
+    {
+        std::lock_guard lock(_lock);
+        if (auto iter = _interned.find(text); iter != _interned.end())
+            return *iter;
+        return *_interned.insert(copy(text)).first;
+    }
+    void string_pool::clear() noexcept
+    {
+        std::lock_guard lock(_lock);
+        _interned.clear();
+        _chunk = 0, _offset = 0;
+    }
+    std::size_t string_pool::capacity() const noexcept
+    {
+        std::lock_guard lock(_lock);
+        std::size_t size = 0;
+        for (auto &chunk : _chunks)
+            size += chunk.size;
+        return size;
+    }
+
+    template <typename T>
+    T *reader::create(context &context, std::string_view name, std::uint32_t row, std::uint32_t col, std::string_view comment, content_node *parent)
+    {
+        auto node = context.arena.create<T>();
+        node->file = context.file;
+        node->row = row;
+        node->col = col;
+        node->comment = comment;
+        node->name = _strings.intern(name);
+        node->qualified_name = parent ? _strings.intern(std::string(parent->qualified_name) + '.' + std::string(node->name)) : node->name;
+        node->parent = parent;
+        return node;
+    }
+    template <typename T>
+    T *reader::create(context &context, std::vector<token>::size_type name, std::vector<token>::size_type comment, content_node *parent)
+    {
+        return create<T>(context, context[name].text, context[name].row, context[name].col, comment != -1 ? context[comment].text : "", parent);
+    }
+    void reader::declare(context &context, content_node *node, symbol_table *table)
+    {
+        auto &scope = context.tables.size() > 0 ? *context.tables[context.tables.size() - 1] : context.src.symbols;
+        scope.symbols.emplace(node->name.data(), symbol_table::symbol{node, table});
+    }
+    reader::symbol_table *reader::open(context &context, symbol_table *table, emodule_node *node, const symbol_table::symbol *symbol)
+    {
+        // a reopened module shares the table, a module of the imports is linked to a table of the source
+        if (auto iter = table->symbols.find(node->name.data()); iter != table->symbols.end())
+            return iter->second.table;
+        return table->symbols.emplace(node->name.data(), symbol_table::symbol{node, &context.src.tables.emplace_back(table, symbol ? symbol->table : nullptr)}).first->second.table;
+    }
+    content_node *reader::read_scopes(context &context, const std::vector<std::size_t> &names, bool upward) const
+    {
+        stopwatch watch(_measure ? &context.src.resolve_time : nullptr);
+        std::vector<std::string_view> ids;
+        for (auto name : names)
+        {
+            auto id = _strings.find(context[name].text);
+            if (!id.data())
+                return nullptr;
+            ids.push_back(id);
+        }
+
+        for (std::size_t size = context.tables.size(), i = size; i <= size; --i)
+        {
+            auto symbol = (i == 0 ? &context.src.symbols : context.tables[i - 1])->find(ids[0], context.src.visible);
+            for (std::size_t j = 1; symbol && j < ids.size(); ++j)
+                symbol = symbol->table ? symbol->table->find(ids[j], context.src.visible) : nullptr;
+            if (symbol)
+                return symbol->node;
 
             if (!upward)
                 break;
         }
         return nullptr;
     }
+    type_node *reader::make_type(context &context, identity format, std::vector<node *> &&values)
+    {
+        auto hash = static_cast<std::size_t>(format);
+        for (auto value : values)
+            hash ^= std::hash<node *>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+        std::lock_guard lock(_type_lock);
+        for (auto [iter, end] = _type_index.equal_range(hash); iter != end; ++iter)
+        {
+            if (iter->second->format == format && iter->second->values == values)
+                return iter->second;
+        }
+
+        auto node = context.arena.create<type_node>();
+        node->format = format;
+        node->values = std::move(values);
+        _type_index.emplace(hash, node);
+        return node;
+    }
     type_node *reader::read_type(context &context) noexcept
     {
-        std::vector<type_node *> stack;
+        /** tuple or map waiting for its closing token */
+        struct frame
+        {
+            identity format;
+            std::vector<node *> values;
+        };
+        std::vector<frame> stack;
         while (read_to_next(context))
         {
             decltype(context.pos) comma = -1;
-            auto curr = stack.size() > 0 ? stack[stack.size() - 1] : nullptr;
+            auto curr = stack.size() > 0 ? &stack[stack.size() - 1] : nullptr;
             if (context.curr() == ",")
             {
                 comma = context.pos;
-                if (auto error = !read_to_next(++context); error || !context.curr().is_entity_name(false))
+                if (auto error = !read_to_next(++context); error || !(context.curr().is_entity_name(false) || context.curr() == "[" || context.curr() == "<"))
                 {
-                    _errors.push_back(context.error(error ? comma : context.pos));
-                    if (curr)
-                        stack[0]->free();
+                    context.src.errors.push_back(context.error(error ? comma : context.pos));
                     return nullptr;
                 }
             }
-            auto &identitfier = context.curr().text;
-            int type = identitfier == "["                          ? -2
-                       : identitfier == "]"                        ? -3
-                       : identitfier == "<"                        ? -4
-                       : identitfier == ">"                        ? -5
-                       : identitfier == keyword(identity::u8)      ? (int)identity::u8
-                       : identitfier == keyword(identity::u16)     ? (int)identity::u16
-                       : identitfier == keyword(identity::u32)     ? (int)identity::u32
-                       : identitfier == keyword(identity::u64)     ? (int)identity::u64
-                       : identitfier == keyword(identity::i8)      ? (int)identity::i8
-                       : identitfier == keyword(identity::i16)     ? (int)identity::i16
-                       : identitfier == keyword(identity::i32)     ? (int)identity::i32
-                       : identitfier == keyword(identity::i64)     ? (int)identity::i64
-                       : identitfier == keyword(identity::f32)     ? (int)identity::f32
-                       : identitfier == keyword(identity::f64)     ? (int)identity::f64
-                       : identitfier == keyword(identity::boolean) ? (int)identity::boolean
-                       : identitfier == keyword(identity::str)     ? (int)identity::str
-                                                                   : -1;
-            if (comma != -1 && ((curr->format != identity::map && curr->format != identity::tuple) || curr->values.size() == 0))
-            {
-                _errors.push_back(context.error(comma));
-                if (curr)
-                    stack[0]->free();
+            auto &current = context.curr();
+            int type = -1;
+            if (current.kind == token::kind_type::punctuation && current.text.size() == 1)
+            {
+                switch (current.text[0])
+                {
+                case '[':
+                    type = -2;
+                    break;
+                case ']':
+                    type = -3;
+                    break;
+                case '<':
+                    type = -4;
+                    break;
+                case '>':
+                    type = -5;
+                    break;
+                }
+            }
+            else if (current.kind == token::kind_type::keyword && current.identifier >= identity::u8 && current.identifier <= identity::str)
+                type = (int)current.identifier;
+            if (comma != -1 && (!curr || curr->values.size() == 0))
+            {
+                context.src.errors.push_back(context.error(comma));
                 return nullptr;
             }
 
             if (type == -2 || type == -4) // [, <
             {
-                bool error = false;
-                auto node = new type_node;
-                node->format = type == -2 ? identity::tuple : identity::map;
-                if (curr)
+                if (curr && curr->format == identity::map && curr->values.size() >= 2)
                 {
-                    if (curr->format == identity::tuple && curr->format == identity::map)
-                    {
-                        if (curr->format == identity::map && curr->values.size() >= 2)
-                            error = true;
-                        else
-                            curr->values.push_back(node);
-                    }
-                    else
-                        error = true;
+                    context.src.errors.push_back(context.error("invaild type"));
+                    return nullptr;
                 }
-                if (error)
+                stack.push_back(frame{type == -2 ? identity::tuple : identity::map, {}});
+                ++context;
+                continue;
+            }
+
+            type_node *node = nullptr;
+            if (type == -3 || type == -5) // ] >
+            {
+                if (curr &&
+                    ((curr->format == identity::tuple && curr->values.size() > 0 && type == -3) ||
+                     (curr->format == identity::map && curr->values.size() == 2 && type == -5)))
+                {
+                    node = make_type(context, curr->format, std::move(curr->values));
+                    stack.pop_back();
+                }
+                else
                 {
-                    delete node;
-                    _errors.push_back(context.error("invaild type"));
-                    if (curr)
-                        stack[0]->free();
+                    context.src.errors.push_back(context.error("invaild type"));
                     return nullptr;
                 }
-                stack.push_back(node);
             }
+            else if (type != -1)
+                node = make_type(context, (identity)type, {});
             else
             {
-                type_node *node = curr;
-                if (type == -3 || type == -5) // ] >
+                content_node *elem = nullptr;
+                std::vector<decltype(context.pos)> names;
+                if (read_to_next(
+                        context, [](const token &token) { return token.is_entity_name(); }, "invaild name"))
                 {
-                    if (curr &&
-                        ((curr->format == identity::tuple && curr->values.size() > 0 && type == -3) ||
-                         (curr->format == identity::map && curr->values.size() == 2 && type == -5)))
-                    {
-                        stack.pop_back();
-                    }
-                    else
+                    names.push_back(context.pos);
+                    while (read_to_next(++context) && context.curr() == ".")
                     {
-                        _errors.push_back(context.error("invaild type"));
-                        if (curr)
-                            stack[0]->free();
-                        return nullptr;
+                        if (!read_to_next(
+                                ++context, [](const token &token) { return token.is_entity_name(); }, "invaild name"))
+                            break;
+                        names.push_back(context.pos);
                     }
+                    context.pos = names[names.size() - 1];
                 }
-                else
-                {
-                    node = new type_node;
-                    node->format = type == -1 ? identity::estruct : (identity)type;
 
-                    if (node->format == identity::estruct)
-                    {
-                        content_node *elem = nullptr;
-                        std::vector<decltype(context.pos)> names;
-                        if (read_to_next(
-                                context, [](const token &token) { return token.is_entity_name(); }, "invaild name"))
-                        {
-                            names.push_back(context.pos);
-                            while (read_to_next(++context) && context.curr() == ".")
-                            {
-                                if (!read_to_next(
-                                        ++context, [](const token &token) { return token.is_entity_name(); }, "invaild name"))
-                                    break;
-                                names.push_back(context.pos);
-                            }
-                            context.pos = names[names.size() - 1];
-                        }
-
-                        if (names.size() > 0 && !context.eof())
-                        {
-                            elem = read_scopes(context, names, true);
-                            if (!elem)
-                                _errors.push_back(context.error("doesn't exist"));
-                            else if (auto type = elem->type(); type == node_type::eenum || type == node_type::estruct)
-                                node->format = type == node_type::eenum ? identity::eenum : identity::estruct;
-                            else
-                                _errors.push_back(context.error("invaild type"));
-                        }
-                        if (!elem)
-                        {
-                            delete node;
-                            if (curr)
-                                stack[0]->free();
-                            return nullptr;
-                        }
-                        node->values.push_back(elem);
-                    }
-                    if (!curr)
-                        curr = node;
+                if (names.size() > 0 && !context.eof())
+                {
+                    elem = read_scopes(context, names, true);
+                    if (!elem)
+                        context.src.errors.push_back(context.error("doesn't exist"));
+                    else if (auto type = elem->type(); type == node_type::eenum || type == node_type::estruct)
+                        node = make_type(context, type == node_type::eenum ? identity::eenum : identity::estruct, {elem});
                     else
-                        curr->values.push_back(node);
+                        context.src.errors.push_back(context.error("invaild type"));
                 }
+                if (!node)
+                    return nullptr;
+            }
 
-                /** array */
-                auto pos = context.pos;
-                bool forward = true;
-                do
+            /** array */
+            auto pos = context.pos;
+            bool forward = true;
+            do
+            {
+                forward = false;
+                read_comment(++context);
+                if (!context.eof() && context.curr() == "[")
                 {
-                    forward = false;
                     read_comment(++context);
-                    if (!context.eof() && context.curr() == "[")
+                    if (!context.eof() && context.curr() == "]")
                     {
-                        read_comment(++context);
-                        if (!context.eof() && context.curr() == "]")
-                        {
-                            auto node_copy = new type_node;
-                            node_copy->format = node->format;
-                            node_copy->values = std::move(node->values);
-                            node->format = identity::array;
-                            node->values.push_back(node_copy);
-                            pos = context.pos;
-                            forward = true;
-                        }
+                        node = make_type(context, identity::array, {node});
+                        pos = context.pos;
+                        forward = true;
                     }
-                } while (forward);
-                context.pos = pos;
-            }
+                }
+            } while (forward);
+            context.pos = pos;
 
             ++context;
-            if (curr && stack.size() == 0)
-                return curr;
+            if (stack.size() == 0)
+                return node;
+            stack[stack.size() - 1].values.push_back(node);
         }
         return nullptr;
     }
@@ -393,7 +1024,7 @@ namespace anybuf
     bool reader::read_import(context &context) noexcept
     {
         read_comment(context);
-        if (!context.eof() && context.curr() == keyword(identity::import))
+        if (!context.eof() && context.curr().is(identity::import))
         {
             if (!read_to_next(
                     ++context, [](const token &token) { return token.is_string(); }, "invaild path"))
@@ -404,26 +1035,15 @@ namespace anybuf
                     ++context, [](const token &token) { return token == ";"; }, "missing \";\""))
                 return false;
 
-            std::filesystem::path import_path(context[pos_path].text.substr(1, context[pos_path].text.size() - 2));
-            if (import_path.is_relative())
-                import_path = std::filesystem::path(context.path).replace_filename(import_path).lexically_normal();
-            if (!import_path.is_absolute() || !std::filesystem::is_regular_file(import_path))
+            auto path = import_path(context.path, context[pos_path].text);
+            auto import_src = path.size() > 0 ? _sources.find(path) : _sources.end();
+            if (import_src == _sources.end())
             {
-                _errors.push_back(context.error(pos_path, "doesn't exist"));
+                context.src.errors.push_back(context.error(pos_path, "doesn't exist"));
                 return false;
             }
-            auto import_path_string = import_path.lexically_normal().string();
-            if (_sources.find(import_path_string) == _sources.end())
-                scan(import_path_string);
-
-            auto &import_src = _sources[import_path_string];
-            if (import_src.status == source::status_type::reading)
-            {
-                _errors.push_back(context.error(pos_path, "import cycling"));
-                return false;
-            }
-
-            if (!read(import_path_string, import_src))
+            // imports are read before, a failed one fails the source silently
+            if (import_src->second.status != source::status_type::read)
                 return false;
 
             ++context.pos;
@@ -434,7 +1054,7 @@ namespace anybuf
     bool reader::read_emodule(context &context) noexcept
     {
         read_comment(context);
-        if (!context.eof() && context.curr() == keyword(identity::emodule))
+        if (!context.eof() && context.curr().is(identity::emodule))
         {
             std::vector<decltype(context.pos)> names;
             if (!read_to_next(
@@ -453,37 +1073,42 @@ namespace anybuf
                 return false;
 
             auto *scope = context.scopes.size() > 0 ? context.scopes[context.scopes.size() - 1] : nullptr;
+            auto *table = context.tables.size() > 0 ? context.tables[context.tables.size() - 1] : &context.src.symbols;
             for (auto &name : names)
             {
-                auto node = new emodule_node;
-                node->src = context.path;
-                node->row = context[name].row;
-                node->col = context[name].col;
-                node->comment = context.comment != -1 ? context[context.comment].text : "";
-                node->name = context[name].text;
-                node->parent = scope;
-                _nodes.push_back(node);
+                auto symbol = table->find(_strings.find(context[name].text), context.src.visible);
+                if (symbol && symbol->node->type() != node_type::emodule)
+                {
+                    context.src.errors.push_back(context.error(name, "redefinition"));
+                    return false;
+                }
 
+                auto node = create<emodule_node>(context, name, context.comment, scope);
                 if (scope)
-                    dynamic_cast<emodule_node *>(scope)->members.push_back(node);
+                    static_cast<emodule_node *>(scope)->members.push_back(node);
+                else
+                    context.src.nodes.push_back(node);
                 scope = node;
+
+                table = open(context, table, node, symbol);
             }
             context.scopes.push_back(scope);
+            context.tables.push_back(table);
 
             ++context;
             while (read_to_next(context))
             {
-                if (context.curr() == keyword(identity::emodule))
+                if (context.curr().is(identity::emodule))
                 {
                     if (!read_emodule(context))
                         return false;
                 }
-                else if (context.curr() == keyword(identity::eenum))
+                else if (context.curr().is(identity::eenum))
                 {
                     if (!read_eenum(context))
                         return false;
                 }
-                else if (context.curr() == keyword(identity::estruct))
+                else if (context.curr().is(identity::estruct))
                 {
                     if (!read_estruct(context))
                         return false;
@@ -498,6 +1123,7 @@ namespace anybuf
                 return false;
             ++context;
             context.scopes.pop_back();
+            context.tables.pop_back();
         }
 
         return true;
@@ -505,7 +1131,7 @@ namespace anybuf
     bool reader::read_eenum(context &context) noexcept
     {
         read_comment(context);
-        if (!context.eof() && context.curr() == keyword(identity::eenum))
+        if (!context.eof() && context.curr().is(identity::eenum))
         {
             decltype(context.comment) comment = context.comment;
 
@@ -514,27 +1140,23 @@ namespace anybuf
                 return false;
             if (read_scopes(context, {context.pos}))
             {
-                _errors.push_back(context.error("redefinition"));
+                context.src.errors.push_back(context.error("redefinition"));
                 return false;
             }
 
-            auto node = new eenum_node;
-            node->src = context.path;
-            node->row = context.curr().row;
-            node->col = context.curr().col;
-            node->comment = comment != -1 ? context[comment].text : "";
-            node->name = context.curr().text;
-            node->parent = context.scopes.size() > 0 ? context.scopes[context.scopes.size() - 1] : nullptr;
+            auto node = create<eenum_node>(context, context.pos, comment, context.scopes.size() > 0 ? context.scopes[context.scopes.size() - 1] : nullptr);
             node->format = identity::i32;
             if (node->parent)
             {
-                if (node->parent->type() == node_type::emodule)
-                    dynamic_cast<emodule_node *>(node->parent)->members.push_back(node);
-                else if (node->parent->type() == node_type::estruct)
-                    dynamic_cast<estruct_node *>(node->parent)->members.push_back(node);
+                visit(node->parent, overloaded{
+                                        [&](emodule_node *parent) { parent->members.push_back(node); },
+                                        [&](estruct_node *parent) { parent->members.push_back(node); },
+                                        [](anybuf::node *) {},
+                                    });
             }
             else
-                _nodes.push_back(node);
+                context.src.nodes.push_back(node);
+            declare(context, node);
 
             if (!read_to_next(++context))
                 return false;
@@ -542,26 +1164,11 @@ namespace anybuf
             {
                 if (!read_to_next(++context))
                     return false;
-                auto const &type = context.curr().text;
-                if (type == keyword(identity::i8))
-                    node->format = identity::i8;
-                else if (type == keyword(identity::i16))
-                    node->format = identity::i16;
-                else if (type == keyword(identity::i32))
-                    node->format = identity::i32;
-                else if (type == keyword(identity::i64))
-                    node->format = identity::i64;
-                else if (type == keyword(identity::u8))
-                    node->format = identity::u8;
-                else if (type == keyword(identity::u16))
-                    node->format = identity::u16;
-                else if (type == keyword(identity::u32))
-                    node->format = identity::u32;
-                else if (type == keyword(identity::u64))
-                    node->format = identity::u64;
+                if (auto const &type = context.curr(); type.kind == token::kind_type::keyword && type.identifier >= identity::u8 && type.identifier <= identity::i64)
+                    node->format = type.identifier;
                 else
                 {
-                    _errors.push_back(context.error("error value type of enum"));
+                    context.src.errors.push_back(context.error("error value type of enum"));
                     return false;
                 }
                 if (!read_to_next(++context))
@@ -569,28 +1176,21 @@ namespace anybuf
             }
             if (context.curr() != "{")
             {
-                _errors.push_back(context.error("missing \"{\""));
+                context.src.errors.push_back(context.error("missing \"{\""));
                 return false;
             }
+            std::unordered_set<std::string_view> names;
+            std::unordered_set<int64_t> values;
             while (read_to_next(++context) && context.curr().is_entity_name())
             {
                 auto const name = context.pos;
-                for (auto const &member : node->members)
+                if (names.count(context[name].text) > 0)
                 {
-                    if (member->name == context[name].text)
-                    {
-                        _errors.push_back(context.error("redefinition"));
-                        return false;
-                    }
+                    context.src.errors.push_back(context.error("redefinition"));
+                    return false;
                 }
 
-                auto member = new eenum_member_node;
-                member->src = context.path;
-                member->row = context[name].row;
-                member->col = context[name].col;
-                member->comment = context.comment != -1 ? context[context.comment].text : "";
-                member->name = context[name].text;
-                member->parent = node;
+                auto member = create<eenum_member_node>(context, name, context.comment, node);
 
                 if (!read_to_next(++context))
                     return false;
@@ -602,7 +1202,7 @@ namespace anybuf
                         return false;
                     if (negative ? value > -1LL * INT32_MIN : value > INT32_MAX)
                     {
-                        _errors.push_back(context.error(name, "out of value range"));
+                        context.src.errors.push_back(context.error(name, "out of value range"));
                         return false;
                     }
                     member->value = negative ? -1LL * value : value;
@@ -617,19 +1217,16 @@ namespace anybuf
                         member->value = last->value + 1;
                         if (member->value > UINT32_MAX)
                         {
-                            _errors.push_back(context.error(name, "out of integer range"));
+                            context.src.errors.push_back(context.error(name, "out of integer range"));
                             return false;
                         }
                     }
                 }
 
-                for (auto const &mem : node->members)
+                if (values.count(member->value) > 0)
                 {
-                    if (mem->value == member->value)
-                    {
-                        _errors.push_back(context.error(name, "value already exists"));
-                        return false;
-                    }
+                    context.src.errors.push_back(context.error(name, "value already exists"));
+                    return false;
                 }
 
                 int64_t min, max;
@@ -644,6 +1241,9 @@ namespace anybuf
                 case identity::i32:
                     min = INT32_MIN, max = INT32_MAX;
                     break;
+                case identity::i64:
+                    min = INT64_MIN, max = INT64_MAX;
+                    break;
                 case identity::u8:
                     min = 0, max = UINT8_MAX;
                     break;
@@ -653,10 +1253,13 @@ namespace anybuf
                 case identity::u32:
                     min = 0, max = UINT32_MAX;
                     break;
+                default:
+                    min = 0, max = INT64_MAX;
+                    break;
                 }
                 if (member->value < min || member->value > max)
                 {
-                    _errors.push_back(context.error(name, "out of value range"));
+                    context.src.errors.push_back(context.error(name, "out of value range"));
                     return false;
                 }
 
@@ -664,10 +1267,12 @@ namespace anybuf
                     break;
                 else if (context.curr() != ",")
                 {
-                    _errors.push_back(context.error("missing \",\""));
+                    context.src.errors.push_back(context.error("missing \",\""));
                     return false;
                 }
                 node->members.push_back(member);
+                names.insert(member->name);
+                values.insert(member->value);
             }
 
             if (!read_to_next(
@@ -682,7 +1287,7 @@ namespace anybuf
     bool reader::read_estruct(context &context) noexcept
     {
         read_comment(context);
-        if (!context.eof() && context.curr() == keyword(identity::estruct))
+        if (!context.eof() && context.curr().is(identity::estruct))
         {
             decltype(context.comment) comment = context.comment;
 
@@ -691,26 +1296,23 @@ namespace anybuf
                 return false;
             if (read_scopes(context, {context.pos}))
             {
-                _errors.push_back(context.error("redefinition"));
+                context.src.errors.push_back(context.error("redefinition"));
                 return false;
             }
 
-            auto node = new estruct_node;
-            node->src = context.path;
-            node->row = context.curr().row;
-            node->col = context.curr().col;
-            node->comment = comment != -1 ? context[comment].text : "";
-            node->name = context.curr().text;
-            node->parent = context.scopes.size() > 0 ? context.scopes[context.scopes.size() - 1] : nullptr;
+            auto node = create<estruct_node>(context, context.pos, comment, context.scopes.size() > 0 ? context.scopes[context.scopes.size() - 1] : nullptr);
             if (node->parent)
             {
-                if (node->parent->type() == node_type::emodule)
-                    dynamic_cast<emodule_node *>(node->parent)->members.push_back(node);
-                else if (node->parent->type() == node_type::estruct)
-                    dynamic_cast<estruct_node *>(node->parent)->members.push_back(node);
+                visit(node->parent, overloaded{
+                                        [&](emodule_node *parent) { parent->members.push_back(node); },
+                                        [&](estruct_node *parent) { parent->members.push_back(node); },
+                                        [](anybuf::node *) {},
+                                    });
             }
             else
-                _nodes.push_back(node);
+                context.src.nodes.push_back(node);
+            auto table = &context.src.tables.emplace_back(context.tables.size() > 0 ? context.tables[context.tables.size() - 1] : &context.src.symbols);
+            declare(context, node, table);
 
             if (!read_to_next(++context))
                 return false;
@@ -735,15 +1337,15 @@ namespace anybuf
                     auto base = read_scopes(context, names, true);
                     if (!base)
                     {
-                        _errors.push_back(context.error(names[names.size() - 1], "doesn't exist"));
+                        context.src.errors.push_back(context.error(names[names.size() - 1], "doesn't exist"));
                         return false;
                     }
                     else if (base->type() != node_type::estruct)
                     {
-                        _errors.push_back(context.error(names[names.size() - 1], "invaild struct"));
+                        context.src.errors.push_back(context.error(names[names.size() - 1], "invaild struct"));
                         return false;
                     }
-                    node->bases.push_back(dynamic_cast<estruct_node *>(base));
+                    node->bases.push_back(static_cast<estruct_node *>(base));
                 } while (!context.eof() && context.curr() == ",");
             }
 
@@ -751,17 +1353,20 @@ namespace anybuf
                     context, [](const token &token) { return token == "{"; }, "missing \"{\""))
                 return false;
             context.scopes.push_back(node);
+            context.tables.push_back(table);
             if (!read_to_next(++context))
                 return false;
 
+            std::unordered_set<std::string_view> names;
+            std::bitset<256> indices;
             while (!context.eof() && context.curr() != "}")
             {
-                if (context.curr() == keyword(identity::eenum))
+                if (context.curr().is(identity::eenum))
                 {
                     if (!read_eenum(context))
                         return false;
                 }
-                else if (context.curr() == keyword(identity::estruct))
+                else if (context.curr().is(identity::estruct))
                 {
                     if (!read_estruct(context))
                         return false;
@@ -770,27 +1375,20 @@ namespace anybuf
                 {
                     if (!context.curr().is_entity_name())
                     {
-                        _errors.push_back(context.error("invaild name"));
+                        context.src.errors.push_back(context.error("invaild name"));
                         return false;
                     }
                     decltype(context.comment) comment = context.comment, name = context.pos;
-                    for (auto const &member : node->members)
+                    // nested enums and structs are in the scope of the struct
+                    if (names.count(context[name].text) > 0 || read_scopes(context, {name}))
                     {
-                        if (member->name == context[name].text)
-                        {
-                            _errors.push_back(context.error("redefinition"));
-                            return false;
-                        }
+                        context.src.errors.push_back(context.error("redefinition"));
+                        return false;
                     }
 
-                    auto member = new estruct_member_node;
-                    member->src = context.path;
-                    member->row = context[name].row;
-                    member->col = context[name].col;
-                    member->comment = comment != -1 ? context[comment].text : "";
-                    member->name = context[name].text;
-                    member->parent = node;
+                    auto member = create<estruct_member_node>(context, name, comment, node);
                     node->members.push_back(member);
+                    names.insert(member->name);
 
                     if (!read_to_next(++context))
                         return false;
@@ -799,14 +1397,14 @@ namespace anybuf
                         ++context;
                         if (context.eof())
                         {
-                            _errors.push_back(context.error(context.size - 1));
+                            context.src.errors.push_back(context.error(context.size - 1));
                             return false;
                         }
                         member->optional = true;
                     }
                     if (context.curr() != ":") // :
                     {
-                        _errors.push_back(context.error());
+                        context.src.errors.push_back(context.error());
                         return false;
                     }
                     if (!read_to_next(++context))
@@ -818,27 +1416,22 @@ namespace anybuf
                         return false;
                     if (negative || value > 255)
                     {
-                        _errors.push_back(context.error(context.pos - 1, "the index should be between 0 and 255"));
+                        context.src.errors.push_back(context.error(context.pos - 1, "the index should be between 0 and 255"));
                         return false;
                     }
-                    for (auto const &member : node->members)
+                    if (indices.test(value))
                     {
-                        if (member->type() == node_type::estruct_member)
-                        {
-                            if (dynamic_cast<estruct_member_node *>(member)->index == value)
-                            {
-                                _errors.push_back(context.error(context.pos - 1, "the index has been repeated"));
-                                return false;
-                            }
-                        }
+                        context.src.errors.push_back(context.error(context.pos - 1, "the index has been repeated"));
+                        return false;
                     }
+                    indices.set(value);
                     member->index = value;
 
                     if (!read_to_next(context))
                         return false;
                     if (context.curr().row == context.last().row && context.curr().col == context.last().col + 1)
                     {
-                        _errors.push_back(context.error()); // need a blank character
+                        context.src.errors.push_back(context.error()); // need a blank character
                         return false;
                     }
 
@@ -862,110 +1455,1453 @@ namespace anybuf
 
             ++context;
             context.scopes.pop_back();
+            context.tables.pop_back();
         }
 
         return true;
     }
-    bool reader::read(const std::string &path, reader::source &src) noexcept
+    bool reader::read(reader::source &src, node_arena &arena) noexcept
+    {
+        context context(_files[src.file], src, arena);
+        do
+        {
+            if (!read_import(context))
+                return false;
+            read_comment(context);
+        } while (!context.eof() && context.curr().is(identity::import));
+
+        while (!context.eof())
+        {
+            read_comment(context);
+            if (context.eof())
+                break;
+
+            if (context.curr().is(identity::emodule))
+            {
+                if (!read_emodule(context))
+                    return false;
+            }
+            else if (context.curr().is(identity::eenum))
+            {
+                if (!read_eenum(context))
+                    return false;
+            }
+            else if (context.curr().is(identity::estruct))
+            {
+                if (!read_estruct(context))
+                    return false;
+            }
+            else
+            {
+                context.src.errors.push_back(context.error());
+                return false;
+            }
+        }
+
+        return true;
+    }
+    bool reader::read_cache(source &src, node_arena &arena)
+    {
+        cache_input input(src.cache);
+        if (input.get<std::uint32_t>() != cache_version || input.get<std::uint64_t>() != cache_build || input.get<std::uint64_t>() != src.hash ||
+            input.get<std::uint64_t>() != src.key || !input.good())
+            return false;
+        for (auto count = input.get<std::uint32_t>(); count > 0 && input.good(); --count)
+            input.get<std::uint32_t>(), input.text();
+
+        context context(_files[src.file], src, arena);
+        // declarations referred to by qualified name, visible from the top level of the source
+        auto find = [&](std::string_view qualified_name) -> content_node * {
+            const symbol_table::symbol *symbol = nullptr;
+            for (std::size_t begin = 0, end = 0; begin <= qualified_name.size(); begin = end + 1)
+            {
+                auto table = symbol ? symbol->table : &src.symbols;
+                end = std::min(qualified_name.find('.', begin), qualified_name.size());
+                auto id = table ? _strings.find(qualified_name.substr(begin, end - begin)) : std::string_view();
+                if (!id.data() || !(symbol = table->find(id, src.visible)))
+                    return nullptr;
+            }
+            return symbol ? symbol->node : nullptr;
+        };
+        auto load_type = [&](auto &load_type) -> type_node * {
+            auto format = static_cast<identity>(input.get<std::uint8_t>());
+            std::vector<node *> values;
+            if (format == identity::eenum || format == identity::estruct)
+            {
+                auto value = find(input.text());
+                if (!value || value->type() != (format == identity::eenum ? node_type::eenum : node_type::estruct))
+                    return nullptr;
+                values.push_back(value);
+            }
+            else if (format == identity::array || format == identity::tuple || format == identity::map)
+            {
+                for (auto count = input.get<std::uint32_t>(); count > 0; --count)
+                {
+                    auto value = load_type(load_type);
+                    if (!value)
+                        return nullptr;
+                    values.push_back(value);
+                }
+            }
+            else if (format < identity::u8 || format > identity::str)
+                return nullptr;
+            return input.good() ? make_type(context, format, std::move(values)) : nullptr;
+        };
+        auto load_node = [&](content_node *parent, auto &load_node) -> bool {
+            auto type = static_cast<node_type>(input.get<std::uint8_t>());
+            auto row = input.get<std::uint32_t>();
+            auto col = input.get<std::uint32_t>();
+            auto name = input.text();
+            auto comment = input.text();
+            if (!input.good() || name.size() == 0)
+                return false;
+            if (comment.size() > 0)
+                comment = _strings.store(comment);
+
+            content_node *node = nullptr;
+            switch (type)
+            {
+            case node_type::emodule:
+            {
+                auto table = context.tables.size() > 0 ? context.tables[context.tables.size() - 1] : &src.symbols;
+                auto emodule = create<emodule_node>(context, name, row, col, comment, parent);
+                context.scopes.push_back(emodule);
+                context.tables.push_back(open(context, table, emodule, table->find(emodule->name, src.visible)));
+                for (auto count = input.get<std::uint32_t>(); count > 0; --count)
+                {
+                    if (!load_node(emodule, load_node))
+                        return false;
+                }
+                context.scopes.pop_back();
+                context.tables.pop_back();
+                node = emodule;
+                break;
+            }
+            case node_type::eenum:
+            {
+                auto eenum = create<eenum_node>(context, name, row, col, comment, parent);
+                eenum->format = static_cast<identity>(input.get<std::uint8_t>());
+                declare(context, eenum);
+                for (auto count = input.get<std::uint32_t>(); count > 0; --count)
+                {
+                    if (!load_node(eenum, load_node))
+                        return false;
+                }
+                node = eenum;
+                break;
+            }
+            case node_type::eenum_member:
+            {
+                if (!parent || parent->type() != node_type::eenum)
+                    return false;
+                auto member = create<eenum_member_node>(context, name, row, col, comment, parent);
+                member->value = input.get<std::int64_t>();
+                node = member;
+                break;
+            }
+            case node_type::estruct:
+            {
+                auto estruct = create<estruct_node>(context, name, row, col, comment, parent);
+                auto table = &src.tables.emplace_back(context.tables.size() > 0 ? context.tables[context.tables.size() - 1] : &src.symbols);
+                declare(context, estruct, table);
+                for (auto count = input.get<std::uint32_t>(); count > 0; --count)
+                {
+                    auto base = find(input.text());
+                    if (!base || base->type() != node_type::estruct)
+                        return false;
+                    estruct->bases.push_back(static_cast<estruct_node *>(base));
+                }
+                context.scopes.push_back(estruct);
+                context.tables.push_back(table);
+                for (auto count = input.get<std::uint32_t>(); count > 0; --count)
+                {
+                    if (!load_node(estruct, load_node))
+                        return false;
+                }
+                context.scopes.pop_back();
+                context.tables.pop_back();
+                node = estruct;
+                break;
+            }
+            case node_type::estruct_member:
+            {
+                if (!parent || parent->type() != node_type::estruct)
+                    return false;
+                auto member = create<estruct_member_node>(context, name, row, col, comment, parent);
+                member->index = input.get<std::uint8_t>();
+                member->optional = input.get<std::uint8_t>() != 0;
+                if (!(member->format = load_type(load_type)))
+                    return false;
+                node = member;
+                break;
+            }
+            default:
+                return false;
+            }
+
+            if (!parent)
+                src.nodes.push_back(node);
+            else
+            {
+                visit(parent, overloaded{
+                                  [&](emodule_node *parent) { parent->members.push_back(node); },
+                                  [&](eenum_node *parent) { parent->members.push_back(static_cast<eenum_member_node *>(node)); },
+                                  [&](estruct_node *parent) { parent->members.push_back(node); },
+                                  [](anybuf::node *) {},
+                              });
+            }
+            return input.good();
+        };
+
+        for (auto count = input.get<std::uint32_t>(); count > 0; --count)
+        {
+            if (!load_node(nullptr, load_node))
+                return false;
+        }
+        return input.good();
+    }
+    std::string reader::write_cache(const source &src) const
+    {
+        std::string entry;
+        cache_output output(entry);
+        output.put(cache_version);
+        output.put(cache_build);
+        output.put(src.hash);
+        output.put(src.key);
+        output.put(static_cast<std::uint32_t>(src.imports.size()));
+        for (auto &import : src.imports)
+        {
+            output.put(static_cast<std::uint32_t>(import.pos));
+            output.put(std::string_view(_files[import.src->file]));
+        }
+
+        auto write_type = [&](const type_node *type, auto &write_type) -> void {
+            output.put(static_cast<std::uint8_t>(type->format));
+            if (type->format == identity::eenum || type->format == identity::estruct)
+                output.put(static_cast<const content_node *>(type->values[0])->qualified_name);
+            else if (type->format == identity::array || type->format == identity::tuple || type->format == identity::map)
+            {
+                output.put(static_cast<std::uint32_t>(type->values.size()));
+                for (auto value : type->values)
+                    write_type(static_cast<const type_node *>(value), write_type);
+            }
+        };
+        auto write_node = [&](const content_node *node, auto &write_node) -> void {
+            output.put(static_cast<std::uint8_t>(node->type()));
+            output.put(node->row);
+            output.put(node->col);
+            output.put(node->name);
+            output.put(node->comment);
+            visit(node, overloaded{
+                            [&](const emodule_node *node) {
+                                output.put(static_cast<std::uint32_t>(node->members.size()));
+                                for (auto member : node->members)
+                                    write_node(member, write_node);
+                            },
+                            [&](const eenum_node *node) {
+                                output.put(static_cast<std::uint8_t>(node->format));
+                                output.put(static_cast<std::uint32_t>(node->members.size()));
+                                for (auto member : node->members)
+                                    write_node(member, write_node);
+                            },
+                            [&](const eenum_member_node *node) { output.put(static_cast<std::int64_t>(node->value)); },
+                            [&](const estruct_node *node) {
+                                output.put(static_cast<std::uint32_t>(node->bases.size()));
+                                for (auto base : node->bases)
+                                    output.put(base->qualified_name);
+                                output.put(static_cast<std::uint32_t>(node->members.size()));
+                                for (auto member : node->members)
+                                    write_node(member, write_node);
+                            },
+                            [&](const estruct_member_node *node) {
+                                output.put(node->index);
+                                output.put(static_cast<std::uint8_t>(node->optional));
+                                write_type(node->format, write_type);
+                            },
+                            [](const anybuf::node *) {},
+                        });
+        };
+
+        output.put(static_cast<std::uint32_t>(src.nodes.size()));
+        for (auto node : src.nodes)
+            write_node(node, write_node);
+        return entry;
+    }
+    void reader::prepare(source &src)
+    {
+        src.scan_time = src.read_time = src.resolve_time = {};
+        // the write time before the content, a write in between is seen by the next reload
+        std::error_code error;
+        src.time = std::filesystem::last_write_time(_files[src.file], error).time_since_epoch().count();
+        src.size = std::filesystem::file_size(_files[src.file], error);
+        src.content.open(_files[src.file]);
+        src.hash = fnv1a(src.content.data());
+
+        src.cache.clear();
+        if (auto entry = _entries.find(_files[src.file]); entry != _entries.end())
+            src.cache.swap(entry->second);
+        else if (_cache.size() > 0)
+        {
+            std::ifstream stream(cache_path(_cache, _files[src.file]), std::ios::binary);
+            src.cache.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        }
+        if (src.cache.size() > 0)
+        {
+            cache_input input(src.cache);
+            if (input.get<std::uint32_t>() != cache_version || input.get<std::uint64_t>() != cache_build || input.get<std::uint64_t>() != src.hash || !input.good())
+                src.cache.clear();
+        }
+        if (src.cache.size() == 0)
+            scan(src);
+    }
+    void reader::scan_imports(source &src)
+    {
+        src.imports.clear();
+        if (src.cache.size() > 0)
+        {
+            cache_input input(src.cache);
+            // the version, the build, the hash and the key, checked by prepare and read_cache
+            input.get<std::uint32_t>(), input.get<std::uint64_t>(), input.get<std::uint64_t>(), input.get<std::uint64_t>();
+            for (auto count = input.get<std::uint32_t>(); count > 0 && input.good(); --count)
+            {
+                auto pos = input.get<std::uint32_t>();
+                auto file = std::string(input.text());
+                if (!input.good() || !std::filesystem::is_regular_file(file))
+                    break;
+                src.imports.push_back(source::import_file{&add(file), pos});
+            }
+            if (input.good())
+                return;
+
+            // an imported file is gone, read the tokens to report it
+            src.imports.clear();
+            src.cache.clear();
+            scan(src);
+        }
+
+        auto &tokens = src.tokens;
+        auto next = [&tokens](std::size_t pos) {
+            while (pos < tokens.size() && tokens[pos].is_comment())
+                ++pos;
+            return pos;
+        };
+
+        // malformed statements are left to the reading
+        for (auto pos = next(0); pos < tokens.size() && tokens[pos].is(identity::import); pos = next(pos + 1))
+        {
+            auto path = next(pos + 1), end = next(path + 1);
+            if (end >= tokens.size() || !tokens[path].is_string() || tokens[end] != ";")
+                break;
+            if (auto file = import_path(_files[src.file], tokens[path].text); file.size() > 0)
+                src.imports.push_back(source::import_file{&add(file), path});
+            pos = end;
+        }
+    }
+    bool reader::resolve(source &src, std::vector<source *> &order)
     {
         switch (src.status)
         {
         case source::status_type::none:
-            src.status = source::status_type::reading;
+        case source::status_type::scanned:
             break;
-        case source::status_type::read:
+        case source::status_type::failed:
+            return false;
+        default:
             return true;
         }
 
-        context context(path, src);
-        do
+        src.status = source::status_type::reading;
+        src.level = 0;
+        src.visible.assign(_files.size(), false);
+        src.visible[src.file] = true;
+        for (auto &import : src.imports)
         {
-            if (!read_import(context))
+            if (import.src->status == source::status_type::reading)
+            {
+                if (src.tokens.size() == 0)
+                    scan(src);
+                src.errors.push_back(context(_files[src.file], src, _arenas[0]).error(import.pos, "import cycling"));
+                src.status = source::status_type::failed;
+                break;
+            }
+            if (!resolve(*import.src, order))
+            {
+                src.status = source::status_type::failed;
+                break;
+            }
+            src.level = std::max(src.level, import.src->level + 1);
+            for (std::size_t i = 0; i < import.src->visible.size(); ++i)
+            {
+                if (import.src->visible[i])
+                    src.visible[i] = true;
+            }
+        }
+        if (src.status == source::status_type::reading)
+        {
+            src.key = src.hash;
+            for (auto &import : src.imports)
+                src.key = fnv1a(std::string_view(reinterpret_cast<const char *>(&import.src->key), sizeof(import.src->key)), src.key);
+            src.status = source::status_type::ready;
+        }
+        order.push_back(&src);
+        return src.status == source::status_type::ready;
+    }
+    void reader::publish(symbol_table &from, symbol_table &to, std::vector<content_node *> &conflicts)
+    {
+        for (auto &[name, symbol] : from.symbols)
+        {
+            auto [iter, inserted] = to.symbols.try_emplace(name, symbol);
+            if (inserted)
+            {
+                // a module takes the members of every source declaring it into a table of the reader
+                if (symbol.node->type() == node_type::emodule)
+                {
+                    iter->second.table = &_published.emplace_back(&to);
+                    publish(*symbol.table, *iter->second.table, conflicts);
+                }
+                continue;
+            }
+            if (iter->second.node->type() == node_type::emodule && symbol.node->type() == node_type::emodule)
+                publish(*symbol.table, *iter->second.table, conflicts);
+            else
+                conflicts.push_back(symbol.node);
+        }
+    }
+
+    void reader::load(const std::string &path) noexcept
+    {
+        _roots.push_back(path);
+        auto absolute_path = std::filesystem::absolute(path).lexically_normal();
+        auto status = std::filesystem::status(absolute_path);
+        if (status.type() == std::filesystem::file_type::directory)
+        {
+            for (auto &entry : std::filesystem::recursive_directory_iterator(absolute_path))
+            {
+                if (entry.is_regular_file())
+                {
+                    auto path = entry.path().string();
+                    if (auto size = path.size(); size > 7 && path[size - 7] == '.' &&
+                                                 path[size - 6] | 32 == 'a' && path[size - 5] | 32 == 'n' &&
+                                                 path[size - 4] | 32 == 'y' && path[size - 3] | 32 == 'b' &&
+                                                 path[size - 2] | 32 == 'u' && path[size - 1] | 32 == 'f')
+                        add(path);
+                }
+            }
+        }
+        else if (status.type() == std::filesystem::file_type::regular)
+        {
+            add(absolute_path.string());
+        }
+    }
+
+    std::size_t reader::scan() noexcept
+    {
+        // open the sources and the imported files that weren't loaded, a level of imports at a time
+        std::vector<source *> sources;
+        for (auto &[path, src] : _sources)
+        {
+            if (src.status == source::status_type::none)
+                sources.push_back(&src);
+        }
+        for (std::size_t begin = 0, end = sources.size(); begin < end; begin = end, end = sources.size())
+        {
+            work_pool::run(end - begin, [&](std::size_t index, std::size_t) { prepare(*sources[begin + index]); });
+
+            auto files = _files.size();
+            for (auto i = begin; i < end; ++i)
+            {
+                scan_imports(*sources[i]);
+                sources[i]->status = source::status_type::scanned;
+            }
+            for (auto i = files; i < _files.size(); ++i)
+                sources.push_back(&_sources[_files[i]]);
+        }
+
+        std::size_t tokens = 0;
+        for (auto src : sources)
+            tokens += src->tokens.size();
+        return tokens;
+    }
+    bool reader::read() noexcept
+    {
+        if (_errors.size() > 0)
+            return false;
+        while (_arenas.size() < work_pool::concurrency())
+            _arenas.emplace_back();
+        _changed.clear();
+
+        scan();
+
+        // the order a reading of one source after another would take, each source after its imports
+        std::vector<source *> order;
+        for (auto &[path, src] : _sources)
+            resolve(src, order);
+
+        std::vector<std::vector<source *>> levels;
+        for (auto src : order)
+        {
+            if (src->status != source::status_type::ready)
+                continue;
+            if (levels.size() <= src->level)
+                levels.resize(src->level + 1);
+            levels[src->level].push_back(src);
+        }
+        for (auto &level : levels)
+        {
+            // the sources kept by a reload are only published again
+            std::vector<source *> sources;
+            for (auto src : level)
+            {
+                if (src->kept)
+                    src->status = source::status_type::read;
+                else
+                    sources.push_back(src);
+            }
+            work_pool::run(sources.size(), [&](std::size_t index, std::size_t worker) {
+                auto &src = *sources[index];
+                stopwatch watch(_measure ? &src.read_time : nullptr);
+                if (src.cache.size() > 0 && !read_cache(src, _arenas[worker]))
+                {
+                    // start over from the tokens
+                    src.cache.clear();
+                    src.symbols.symbols.clear();
+                    src.tables.clear();
+                    src.nodes.clear();
+                    scan(src);
+                }
+                src.status = src.cache.size() > 0 || read(src, _arenas[worker]) ? source::status_type::read : source::status_type::failed;
+            });
+
+            // published in order, the same declaration is the redefinition whichever source was read first
+            for (auto src : level)
+            {
+                if (src->status != source::status_type::read)
+                    continue;
+                std::vector<content_node *> conflicts;
+                publish(src->symbols, _symbols, conflicts);
+                if (conflicts.size() > 0)
+                {
+                    auto first = *std::min_element(conflicts.begin(), conflicts.end(), [](content_node *a, content_node *b) {
+                        return a->row < b->row || (a->row == b->row && a->col < b->col);
+                    });
+                    src->errors.push_back(_files[first->file] + ':' + std::to_string(first->row) + ':' + std::to_string(first->col) +
+                                          " \"" + std::string(first->name) + "\": redefinition");
+                    src->status = source::status_type::failed;
+                }
+            }
+        }
+
+        _stats = statistics();
+        _stats.files.resize(_files.size());
+        for (auto src : order)
+        {
+            _nodes.insert(_nodes.end(), src->nodes.begin(), src->nodes.end());
+            std::move(src->errors.begin(), src->errors.end(), std::back_inserter(_errors));
+            src->errors.clear();
+            auto restored = src->cache.size() > 0 || src->kept;
+            if (!restored)
+                _changed.push_back(_files[src->file]);
+            _stats.files[src->file] = file_stats{src->kept ? 0 : src->tokens.size(), restored, src->scan_time, src->read_time, src->resolve_time};
+        }
+
+        if (_cache.size() > 0)
+        {
+            std::vector<source *> written;
+            for (auto src : order)
+            {
+                if (src->status == source::status_type::read && src->cache.size() == 0 && !src->kept)
+                    written.push_back(src);
+            }
+
+            std::error_code error;
+            std::filesystem::create_directories(_cache, error);
+            work_pool::run(written.size(), [&](std::size_t index, std::size_t) {
+                auto &src = *written[index];
+                auto path = cache_path(_cache, _files[src.file]);
+                auto temp = std::filesystem::path(path).concat(".tmp");
+                auto entry = write_cache(src);
+                if (std::ofstream stream(temp, std::ios::binary | std::ios::trunc); !stream.write(entry.data(), entry.size()))
+                    return;
+                std::error_code code;
+                std::filesystem::rename(temp, path, code);
+            });
+        }
+        for (auto src : order)
+        {
+            std::string().swap(src->cache);
+            src->kept = false;
+        }
+
+        // distinct types in the order of the nodes, whichever worker made them, and the nodes of each type
+        _types.clear();
+        std::unordered_set<type_node *> types;
+        auto collect = [&](type_node *type, auto &collect) -> void {
+            if (!types.insert(type).second)
+                return;
+            if (type->format == identity::array || type->format == identity::tuple || type->format == identity::map)
+            {
+                for (auto value : type->values)
+                    collect(static_cast<type_node *>(value), collect);
+            }
+            _types.push_back(type);
+        };
+        auto walk = [&](content_node *node, auto &walk) -> void {
+            ++_stats.nodes[static_cast<std::size_t>(node->type())];
+            visit(node, overloaded{
+                            [&](emodule_node *node) {
+                                for (auto member : node->members)
+                                    walk(member, walk);
+                            },
+                            [&](eenum_node *node) {
+                                for (auto member : node->members)
+                                    walk(member, walk);
+                            },
+                            [&](estruct_node *node) {
+                                for (auto member : node->members)
+                                    walk(member, walk);
+                            },
+                            [&](estruct_member_node *node) {
+                                if (node->format)
+                                    collect(node->format, collect);
+                            },
+                            [](anybuf::node *) {},
+                        });
+        };
+        for (auto node : _nodes)
+            walk(node, walk);
+        _stats.nodes[static_cast<std::size_t>(node_type::type)] = _types.size();
+        _stats.memory = _strings.capacity();
+        for (auto &arena : _arenas)
+            _stats.memory += arena.capacity();
+
+        return _errors.size() == 0;
+    }
+    bool reader::reload() noexcept
+    {
+        if (_reread > _sources.size())
+            return rebuild();
+
+        // the sources whose files are gone or hold other bytes, and the ones that weren't read
+        std::vector<std::string> gone;
+        std::unordered_set<source *> affected;
+        for (auto &[path, src] : _sources)
+        {
+            std::error_code error;
+            std::int64_t time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+            std::uint64_t size = error ? 0 : std::filesystem::file_size(path, error);
+            if (error)
+            {
+                gone.push_back(path);
+                affected.insert(&src);
+                continue;
+            }
+            if (src.status == source::status_type::read && time == src.time && size == src.size)
+                continue;
+            // a file written with the same bytes, as an editor saving it unchanged does
+            if (mapping content; src.status == source::status_type::read && size == src.size && content.open(path) && fnv1a(content.data()) == src.hash)
+            {
+                src.time = time;
+                continue;
+            }
+            affected.insert(&src);
+        }
+
+        // and the sources importing them, which refer to their nodes
+        std::unordered_map<source *, std::vector<source *>> importers;
+        for (auto &[path, src] : _sources)
+        {
+            for (auto &import : src.imports)
+                importers[import.src].push_back(&src);
+        }
+        for (std::vector<source *> pending(affected.begin(), affected.end()); pending.size() > 0;)
+        {
+            auto src = pending.back();
+            pending.pop_back();
+            for (auto importer : importers[src])
+            {
+                if (affected.insert(importer).second)
+                    pending.push_back(importer);
+            }
+        }
+
+        // the others keep their nodes and tables, the published tables are made again from them
+        for (auto &[path, src] : _sources)
+        {
+            if (affected.count(&src) == 0)
+            {
+                src.kept = true;
+                src.status = source::status_type::scanned;
+                src.scan_time = src.read_time = src.resolve_time = {};
+                // the published tables their modules were linked to are made again
+                for (auto &table : src.tables)
+                    table.shared = nullptr;
+                continue;
+            }
+            if (src.status == source::status_type::read)
+                ++_reread;
+            src.status = source::status_type::none;
+            src.tokens.clear();
+            src.imports.clear();
+            src.symbols.symbols.clear();
+            src.tables.clear();
+            src.nodes.clear();
+            src.errors.clear();
+        }
+        for (auto &path : gone)
+            _sources.erase(path);
+        _symbols.symbols.clear();
+        _published.clear();
+        _nodes.clear();
+        _errors.clear();
+
+        // new files under the loaded directories are added unscanned
+        auto roots = std::move(_roots);
+        for (auto &root : roots)
+            load(root);
+        auto result = read();
+        _changed.insert(_changed.end(), gone.begin(), gone.end());
+        return result;
+    }
+    bool reader::rebuild() noexcept
+    {
+        std::vector<std::string> paths;
+        for (auto &[path, src] : _sources)
+        {
+            paths.push_back(path);
+            if (src.status == source::status_type::read)
+                _entries.emplace(path, write_cache(src));
+        }
+
+        auto roots = std::move(_roots);
+        clear();
+        for (auto &root : roots)
+            load(root);
+        auto result = read();
+
+        // sources that are gone changed too
+        for (auto &path : paths)
+        {
+            if (_sources.find(path) == _sources.end())
+                _changed.push_back(path);
+        }
+        _entries.clear();
+        return result;
+    }
+    void reader::clear() noexcept
+    {
+        _roots.clear();
+        _changed.clear();
+        _errors.clear();
+        _nodes.clear();
+        _types.clear();
+        _type_index.clear();
+        for (auto &arena : _arenas)
+            arena.clear();
+        _symbols.symbols.clear();
+        _published.clear();
+        _reread = 0;
+        _strings.clear();
+        _files.clear();
+        _sources.clear();
+    }
+    void reader::release_sources() noexcept
+    {
+        auto release = [this](content_node *node, auto &release) -> void {
+            node->comment = _strings.store(node->comment);
+            visit(node, overloaded{
+                            [&](emodule_node *node) {
+                                for (auto member : node->members)
+                                    release(member, release);
+                            },
+                            [&](eenum_node *node) {
+                                for (auto member : node->members)
+                                    release(member, release);
+                            },
+                            [&](estruct_node *node) {
+                                for (auto member : node->members)
+                                    release(member, release);
+                            },
+                            [](anybuf::node *) {},
+                        });
+        };
+        for (auto node : _nodes)
+            release(node, release);
+
+        for (auto &[path, src] : _sources)
+        {
+            if (src.status == source::status_type::read)
+            {
+                src.tokens = std::vector<token>();
+                src.content.close();
+            }
+        }
+    }
+    std::vector<std::string> reader::lint() const
+    {
+        // limits past which a declaration is reported
+        constexpr std::size_t max_nesting = 3;
+        constexpr std::size_t max_inheritance = 4;
+        constexpr std::size_t sparse_slack = 8;
+
+        std::vector<std::string> warnings;
+        auto warn = [&](const content_node *node, const std::string &message) {
+            warnings.push_back(_files[node->file] + ':' + std::to_string(node->row) + ':' + std::to_string(node->col) +
+                               " \"" + std::string(node->qualified_name) + "\": " + message);
+        };
+
+        // fields of the struct and its bases, each base counted once
+        auto fields = [](const estruct_node *node, std::size_t &count, std::size_t &optional) {
+            std::unordered_set<const estruct_node *> visited;
+            std::vector<const estruct_node *> stack{node};
+            while (stack.size() > 0)
+            {
+                auto curr = stack.back();
+                stack.pop_back();
+                if (!visited.insert(curr).second)
+                    continue;
+                for (auto member : curr->members)
+                {
+                    if (member->type() == node_type::estruct_member)
+                        ++count, optional += static_cast<estruct_member_node *>(member)->optional ? 1 : 0;
+                }
+                stack.insert(stack.end(), curr->bases.begin(), curr->bases.end());
+            }
+        };
+        std::unordered_map<const estruct_node *, std::size_t> depths;
+        auto inheritance = [&](const estruct_node *node, auto &inheritance) -> std::size_t {
+            if (auto iter = depths.find(node); iter != depths.end())
+                return iter->second;
+            std::size_t depth = 0;
+            for (auto base : node->bases)
+                depth = std::max(depth, inheritance(base, inheritance) + 1);
+            return depths[node] = depth;
+        };
+        // depth of the containers, the str keys and the arrays of mostly optional structs in the type
+        auto check_type = [&](const estruct_member_node *member, const type_node *type, auto &check_type) -> std::size_t {
+            if (type->format != identity::array && type->format != identity::tuple && type->format != identity::map)
+                return 0;
+            if (type->format == identity::map && static_cast<type_node *>(type->values[0])->format == identity::str)
+                warn(member, "map keyed by str, hashing and comparing the keys is slow, an enum or an integer key is cheaper");
+            if (auto element = static_cast<type_node *>(type->values[0]); type->format == identity::array && element->format == identity::estruct)
+            {
+                std::size_t count = 0, optional = 0;
+                fields(static_cast<estruct_node *>(element->values[0]), count, optional);
+                if (optional * 2 > count)
+                    warn(member, "array of a struct with mostly optional fields, " + std::to_string(optional) + " of " + std::to_string(count) +
+                                     ", every element pays for the absent ones");
+            }
+
+            std::size_t depth = 0;
+            for (auto value : type->values)
+                depth = std::max(depth, check_type(member, static_cast<type_node *>(value), check_type));
+            return depth + 1;
+        };
+
+        auto check = [&](const content_node *node, auto &check) -> void {
+            visit(node, overloaded{
+                            [&](const emodule_node *node) {
+                                for (auto member : node->members)
+                                    check(member, check);
+                            },
+                            [&](const eenum_node *node) {
+                                if (node->members.size() == 0)
+                                    return;
+                                auto [min, max] = std::minmax_element(node->members.begin(), node->members.end(), [](auto a, auto b) { return a->value < b->value; });
+                                auto fits = [&](identity format) {
+                                    switch (format)
+                                    {
+                                    case identity::u8:
+                                        return (*min)->value >= 0 && (*max)->value <= UINT8_MAX;
+                                    case identity::u16:
+                                        return (*min)->value >= 0 && (*max)->value <= UINT16_MAX;
+                                    case identity::i8:
+                                        return (*min)->value >= INT8_MIN && (*max)->value <= INT8_MAX;
+                                    case identity::i16:
+                                        return (*min)->value >= INT16_MIN && (*max)->value <= INT16_MAX;
+                                    default:
+                                        return false;
+                                    }
+                                };
+                                auto narrower = node->format == identity::u32   ? std::initializer_list<identity>{identity::u8, identity::u16}
+                                                : node->format == identity::u16 ? std::initializer_list<identity>{identity::u8}
+                                                : node->format == identity::i32 ? std::initializer_list<identity>{identity::i8, identity::i16}
+                                                : node->format == identity::i16 ? std::initializer_list<identity>{identity::i8}
+                                                                                : std::initializer_list<identity>{};
+                                for (auto format : narrower)
+                                {
+                                    if (fits(format))
+                                    {
+                                        warn(node, std::string("values fit in ") + keyword(format) + ", " + keyword(node->format) + " wastes bytes on the wire");
+                                        break;
+                                    }
+                                }
+                            },
+                            [&](const estruct_node *node) {
+                                if (auto depth = inheritance(node, inheritance); depth > max_inheritance)
+                                    warn(node, "inheritance " + std::to_string(depth) + " deep, every base adds a field count and a decode call");
+
+                                std::size_t count = 0, max_index = 0;
+                                for (auto member : node->members)
+                                {
+                                    if (member->type() != node_type::estruct_member)
+                                    {
+                                        check(member, check);
+                                        continue;
+                                    }
+                                    auto field = static_cast<const estruct_member_node *>(member);
+                                    ++count, max_index = std::max<std::size_t>(max_index, field->index);
+                                    if (auto depth = check_type(field, field->format, check_type); depth > max_nesting)
+                                        warn(field, "type nested " + std::to_string(depth) + " deep, each level is a count and an allocation");
+                                }
+                                if (count > 0 && max_index + 1 > count * 2 + sparse_slack)
+                                    warn(node, "field indices spread sparsely, " + std::to_string(count) + " fields up to index " + std::to_string(max_index) +
+                                                   ", " + std::to_string(255 - max_index) + " indices left above it");
+                            },
+                            [](const anybuf::node *) {},
+                        });
+        };
+        for (auto node : _nodes)
+            check(node, check);
+        return warnings;
+    }
+
+} // namespace anybuf
+
+namespace anybuf
+{
+    bool schema::write(const std::string &path, const reader &reader) noexcept
+    {
+        // every record has its offset before any is filled, nodes in depth first order, then types
+        std::vector<const content_node *> nodes;
+        std::unordered_map<const node *, std::uint32_t> offsets;
+        auto collect = [&](const content_node *node, auto &collect) -> void {
+            offsets[node] = static_cast<std::uint32_t>(sizeof(header_record) + nodes.size() * sizeof(node_record));
+            nodes.push_back(node);
+            visit(node, overloaded{
+                            [&](const emodule_node *node) {
+                                for (auto member : node->members)
+                                    collect(member, collect);
+                            },
+                            [&](const eenum_node *node) {
+                                for (auto member : node->members)
+                                    collect(member, collect);
+                            },
+                            [&](const estruct_node *node) {
+                                for (auto member : node->members)
+                                    collect(member, collect);
+                            },
+                            [](const anybuf::node *) {},
+                        });
+        };
+        for (auto node : reader.nodes())
+            collect(node, collect);
+
+        auto &types = reader.types();
+        auto types_offset = sizeof(header_record) + nodes.size() * sizeof(node_record);
+        for (std::size_t i = 0; i < types.size(); ++i)
+            offsets[types[i]] = static_cast<std::uint32_t>(types_offset + i * sizeof(type_record));
+        auto arrays_offset = types_offset + types.size() * sizeof(type_record);
+
+        std::vector<std::uint32_t> arrays;
+        auto list = [&](const auto &elements) {
+            span result{static_cast<std::uint32_t>(arrays_offset + arrays.size() * sizeof(std::uint32_t)), static_cast<std::uint32_t>(elements.size())};
+            for (auto element : elements)
+            {
+                auto offset = offsets.find(element);
+                arrays.push_back(offset != offsets.end() ? offset->second : 0);
+            }
+            return result;
+        };
+        // string offsets are relative to the strings until the arrays are done
+        std::string strings;
+        std::unordered_map<std::string_view, std::uint32_t> interned;
+        auto text = [&](std::string_view text) {
+            auto [iter, inserted] = interned.try_emplace(text, static_cast<std::uint32_t>(strings.size()));
+            if (inserted)
+                strings.append(text);
+            return span{iter->second, static_cast<std::uint32_t>(text.size())};
+        };
+
+        header_record header{};
+        std::copy_n("ABFC", 4, header.magic);
+        header.version = version;
+        header.nodes = list(reader.nodes());
+        header.types = list(types);
+
+        std::vector<node_record> node_records(nodes.size());
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            auto node = nodes[i];
+            auto &record = node_records[i];
+            record.type = static_cast<std::uint32_t>(node->type());
+            record.file = node->file;
+            record.row = node->row;
+            record.col = node->col;
+            record.parent = node->parent ? offsets[node->parent] : 0;
+            record.name = text(node->name);
+            record.qualified_name = text(node->qualified_name);
+            record.comment = text(node->comment);
+            visit(node, overloaded{
+                            [&](const emodule_node *node) { record.members = list(node->members); },
+                            [&](const eenum_node *node) {
+                                record.format = static_cast<std::uint32_t>(node->format);
+                                record.members = list(node->members);
+                            },
+                            [&](const eenum_member_node *node) { record.value = node->value; },
+                            [&](const estruct_node *node) {
+                                record.bases = list(node->bases);
+                                record.members = list(node->members);
+                            },
+                            [&](const estruct_member_node *node) {
+                                record.index = node->index;
+                                record.optional = node->optional;
+                                record.format = node->format ? offsets[node->format] : 0;
+                            },
+                            [](const anybuf::node *) {},
+                        });
+        }
+        std::vector<type_record> type_records(types.size());
+        for (std::size_t i = 0; i < types.size(); ++i)
+        {
+            type_records[i].format = static_cast<std::uint32_t>(types[i]->format);
+            type_records[i].values = list(types[i]->values);
+        }
+        std::vector<span> files;
+        for (auto &file : reader.files())
+            files.push_back(text(file));
+
+        auto files_offset = arrays_offset + arrays.size() * sizeof(std::uint32_t);
+        auto strings_offset = files_offset + files.size() * sizeof(span);
+        auto size = strings_offset + strings.size();
+        if (size > UINT32_MAX)
+            return false;
+        header.size = static_cast<std::uint32_t>(size);
+        header.files = span{static_cast<std::uint32_t>(files_offset), static_cast<std::uint32_t>(files.size())};
+        for (auto &record : node_records)
+        {
+            for (auto text : {&record.name, &record.qualified_name, &record.comment})
+                text->offset += static_cast<std::uint32_t>(strings_offset);
+        }
+        for (auto &file : files)
+            file.offset += static_cast<std::uint32_t>(strings_offset);
+
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char *>(node_records.data()), node_records.size() * sizeof(node_record));
+        stream.write(reinterpret_cast<const char *>(type_records.data()), type_records.size() * sizeof(type_record));
+        stream.write(reinterpret_cast<const char *>(arrays.data()), arrays.size() * sizeof(std::uint32_t));
+        stream.write(reinterpret_cast<const char *>(files.data()), files.size() * sizeof(span));
+        stream.write(strings.data(), strings.size());
+        return static_cast<bool>(stream);
+    }
+    bool schema::open(const std::string &path) noexcept
+    {
+        close();
+        if (!_content.open(path))
+            return false;
+
+        auto data = _content.data();
+        auto header = reinterpret_cast<const header_record *>(data.data());
+        if (data.size() < sizeof(header_record) || std::string_view(header->magic, 4) != "ABFC" ||
+            header->version != version || header->size != data.size() || !check(data))
+        {
+            _content.close();
+            return false;
+        }
+        _header = header;
+        return true;
+    }
+    bool schema::check(std::string_view data) noexcept
+    {
+        auto base = data.data();
+        auto header = reinterpret_cast<const header_record *>(base);
+        // count elements of the size at the offset, after the header for a record
+        auto fits = [&](std::uint64_t offset, std::uint64_t count, std::size_t size, std::size_t align) {
+            return offset % align == 0 && offset <= data.size() && count <= (data.size() - offset) / size;
+        };
+        auto text = [&](span text) { return fits(text.offset, text.size, 1, 1); };
+        auto placed = [&](std::uint32_t offset, std::size_t size, std::size_t align) { return offset >= sizeof(header_record) && fits(offset, 1, size, align); };
+
+        if (!fits(header->files.offset, header->files.size, sizeof(span), alignof(span)))
+            return false;
+        auto files = reinterpret_cast<const span *>(base + header->files.offset);
+        for (std::uint32_t i = 0; i < header->files.size; ++i)
+        {
+            if (!text(files[i]))
                 return false;
-            read_comment(context);
-        } while (!context.eof() && context.curr() == keyword(identity::import));
+        }
 
-        while (!context.eof())
+        // the node and type records from the lists of the header, each checked once however many refer to it
+        std::vector<std::pair<std::uint32_t, bool>> pending;
+        std::unordered_set<std::uint64_t> checked;
+        auto list = [&](span list, bool node) {
+            if (!fits(list.offset, list.size, sizeof(std::uint32_t), alignof(std::uint32_t)))
+                return false;
+            auto offsets = reinterpret_cast<const std::uint32_t *>(base + list.offset);
+            for (std::uint32_t i = 0; i < list.size; ++i)
+                pending.emplace_back(offsets[i], node);
+            return true;
+        };
+        if (!list(header->nodes, true) || !list(header->types, false))
+            return false;
+        while (pending.size() > 0)
+        {
+            auto [offset, node] = pending.back();
+            pending.pop_back();
+            if (!checked.insert(std::uint64_t(offset) << 1 | node).second)
+                continue;
+
+            if (!node)
+            {
+                if (!placed(offset, sizeof(type_record), alignof(type_record)))
+                    return false;
+                auto type = reinterpret_cast<const type_record *>(base + offset);
+                auto format = static_cast<identity>(type->format);
+                // an enum or a struct refers to its node record
+                auto named = format == identity::eenum || format == identity::estruct;
+                if ((named && type->values.size != 1) || !list(type->values, named))
+                    return false;
+                continue;
+            }
+
+            if (!placed(offset, sizeof(node_record), alignof(node_record)))
+                return false;
+            auto record = reinterpret_cast<const node_record *>(base + offset);
+            if (record->type > static_cast<std::uint32_t>(node_type::estruct_member) || record->file >= header->files.size ||
+                !text(record->name) || !text(record->qualified_name) || !text(record->comment) ||
+                !list(record->members, true) || !list(record->bases, true))
+                return false;
+            if (record->parent)
+                pending.emplace_back(record->parent, true);
+            if (static_cast<node_type>(record->type) == node_type::estruct_member)
+                pending.emplace_back(record->format, false);
+        }
+        return true;
+    }
+    void schema::close() noexcept
+    {
+        _header = nullptr;
+        _content.close();
+    }
+    std::vector<std::string_view> schema::files() const noexcept
+    {
+        std::vector<std::string_view> files;
+        if (_header)
+        {
+            auto base = _content.data().data();
+            auto spans = reinterpret_cast<const span *>(base + _header->files.offset);
+            for (std::uint32_t i = 0; i < _header->files.size; ++i)
+                files.emplace_back(base + spans[i].offset, spans[i].size);
+        }
+        return files;
+    }
+} // namespace anybuf
+
+namespace anybuf
+{
+#ifdef __linux__
+    watcher::watcher() noexcept : _fd(inotify_init1(IN_CLOEXEC)) {}
+    watcher::~watcher() noexcept
+    {
+        if (_fd >= 0)
+            ::close(_fd);
+    }
+    void watcher::add(const std::string &directory) noexcept
+    {
+        auto wd = inotify_add_watch(_fd, directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF);
+        if (wd >= 0)
+            _directories[wd] = directory;
+
+        std::error_code error;
+        for (auto &entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_directory(error))
+                add(entry.path().string());
+        }
+    }
+    bool watcher::watch(const std::string &path) noexcept
+    {
+        auto absolute_path = std::filesystem::absolute(path).lexically_normal();
+        auto status = std::filesystem::status(absolute_path);
+        if (_fd < 0 || (status.type() != std::filesystem::file_type::directory && status.type() != std::filesystem::file_type::regular))
+            return false;
+
+        _paths.push_back(absolute_path.string());
+        // a file is watched through its directory, editors often replace the file
+        add(status.type() == std::filesystem::file_type::directory ? absolute_path.string() : absolute_path.parent_path().string());
+        return true;
+    }
+    std::vector<std::string> watcher::wait() noexcept
+    {
+        std::vector<std::string> changes;
+        alignas(inotify_event) char buffer[16 * 1024];
+        for (int timeout = -1;; timeout = 50)
         {
-            read_comment(context);
-            if (context.eof())
+            pollfd fd{_fd, POLLIN, 0};
+            if (poll(&fd, 1, timeout) <= 0)
+                break;
+            auto size = ::read(_fd, buffer, sizeof(buffer));
+            if (size <= 0)
                 break;
 
-            if (context.curr() == keyword(identity::emodule))
+            for (decltype(size) pos = 0; pos < size;)
             {
-                if (!read_emodule(context))
-                    return false;
+                auto event = reinterpret_cast<const inotify_event *>(buffer + pos);
+                pos += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                    changes.insert(changes.end(), _paths.begin(), _paths.end());
+                auto directory = _directories.find(event->wd);
+                if (directory == _directories.end())
+                    continue;
+                if (event->mask & IN_IGNORED)
+                {
+                    _directories.erase(directory);
+                    continue;
+                }
+
+                auto path = event->len > 0 ? directory->second + '/' + event->name : directory->second;
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                    add(path);
+                // only files under the watched paths
+                for (auto &watched : _paths)
+                {
+                    if (path.compare(0, watched.size(), watched) == 0 && (path.size() == watched.size() || path[watched.size()] == '/'))
+                    {
+                        changes.push_back(path);
+                        break;
+                    }
+                }
             }
-            else if (context.curr() == keyword(identity::eenum))
+        }
+
+        std::sort(changes.begin(), changes.end());
+        changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+        return changes;
+    }
+#else
+    watcher::watcher() noexcept {}
+    watcher::~watcher() noexcept {}
+    std::map<std::string, long long> watcher::snapshot() const noexcept
+    {
+        std::map<std::string, long long> times;
+        std::error_code error;
+        auto add = [&](const std::filesystem::path &path) {
+            times[path.string()] = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        };
+        for (auto &path : _paths)
+        {
+            if (std::filesystem::is_directory(path, error))
             {
-                if (!read_eenum(context))
-                    return false;
+                for (auto &entry : std::filesystem::recursive_directory_iterator(path, error))
+                {
+                    if (entry.is_regular_file(error))
+                        add(entry.path());
+                }
             }
-            else if (context.curr() == keyword(identity::estruct))
+            else if (std::filesystem::exists(path, error))
+                add(path);
+        }
+        return times;
+    }
+    bool watcher::watch(const std::string &path) noexcept
+    {
+        std::error_code error;
+        auto absolute_path = std::filesystem::absolute(path, error).lexically_normal();
+        if (error || !std::filesystem::exists(absolute_path, error))
+            return false;
+        _paths.push_back(absolute_path.string());
+        _times = snapshot();
+        return true;
+    }
+    std::vector<std::string> watcher::wait() noexcept
+    {
+        std::vector<std::string> changes;
+        while (changes.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            auto times = snapshot();
+            for (auto &[path, time] : times)
             {
-                if (!read_estruct(context))
-                    return false;
+                if (auto iter = _times.find(path); iter == _times.end() || iter->second != time)
+                    changes.push_back(path);
             }
-            else
+            for (auto &[path, time] : _times)
             {
-                _errors.push_back(context.error());
-                return false;
+                if (times.find(path) == times.end())
+                    changes.push_back(path);
             }
+            _times = std::move(times);
         }
-
-        return true;
+        std::sort(changes.begin(), changes.end());
+        return changes;
     }
-
-    void reader::load(const std::string &path) noexcept
+#endif
+    bool writer::reach(const std::vector<content_node *> &nodes)
     {
-        auto absolute_path = std::filesystem::absolute(path).lexically_normal();
-        auto status = std::filesystem::status(absolute_path);
-        if (status.type() == std::filesystem::file_type::directory)
+        // modules may be split over files, a name can have several nodes
+        std::unordered_map<std::string_view, std::vector<content_node *>> names;
+        auto index = [&](content_node *node, auto &index) -> void {
+            if (node->type() == node_type::estruct_member)
+                return;
+            names[node->qualified_name].push_back(node);
+            visit(node, overloaded{
+                            [&](emodule_node *node) {
+                                for (auto member : node->members)
+                                    index(member, index);
+                            },
+                            [&](estruct_node *node) {
+                                for (auto member : node->members)
+                                    index(member, index);
+                            },
+                            [](anybuf::node *) {},
+                        });
+        };
+        for (auto node : nodes)
+            index(node, index);
+
+        std::vector<content_node *> stack;
+        auto mark = [&](content_node *node) {
+            if (_reachable.insert(node).second)
+                stack.push_back(node);
+        };
+        auto mark_type = [&](anybuf::node *node, auto &mark_type) -> void {
+            if (node->type() == node_type::type)
+            {
+                for (auto value : static_cast<type_node *>(node)->values)
+                    mark_type(value, mark_type);
+            }
+            else
+                mark(static_cast<content_node *>(node));
+        };
+        auto mark_all = [&](content_node *node, auto &mark_all) -> void {
+            if (node->type() == node_type::estruct_member)
+                return;
+            mark(node);
+            visit(node, overloaded{
+                            [&](emodule_node *node) {
+                                for (auto member : node->members)
+                                    mark_all(member, mark_all);
+                            },
+                            [&](estruct_node *node) {
+                                for (auto member : node->members)
+                                    mark_all(member, mark_all);
+                            },
+                            [](anybuf::node *) {},
+                        });
+        };
+
+        auto result = true;
+        _reachable.clear();
+        for (auto &root : _roots)
         {
-            for (auto &entry : std::filesystem::recursive_directory_iterator(absolute_path))
+            auto iter = names.find(root);
+            if (iter == names.end())
             {
-                if (entry.is_regular_file())
-                {
-                    auto path = entry.path().string();
-                    if (auto size = path.size(); size > 7 && path[size - 7] == '.' &&
-                                                 path[size - 6] | 32 == 'a' && path[size - 5] | 32 == 'n' &&
-                                                 path[size - 4] | 32 == 'y' && path[size - 3] | 32 == 'b' &&
-                                                 path[size - 2] | 32 == 'u' && path[size - 1] | 32 == 'f')
-                        scan(path);
-                }
+                _errors.push_back(root + ": root doesn't exist");
+                result = false;
+                continue;
             }
+            for (auto node : iter->second)
+                node->type() == node_type::emodule ? mark_all(node, mark_all) : mark(node);
         }
-        else if (status.type() == std::filesystem::file_type::regular)
+
+        // a reached type needs the scopes around it, a module reached that way only needs the reached part of it
+        while (stack.size() > 0)
         {
-            scan(absolute_path.string());
+            auto node = stack.back();
+            stack.pop_back();
+            if (node->parent)
+                mark(node->parent);
+            visit(node, overloaded{
+                            [&](estruct_node *node) {
+                                for (auto base : node->bases)
+                                    mark(base);
+                                for (auto member : node->members)
+                                {
+                                    if (member->type() == node_type::estruct_member && static_cast<estruct_member_node *>(member)->format)
+                                        mark_type(static_cast<estruct_member_node *>(member)->format, mark_type);
+                                }
+                            },
+                            [](anybuf::node *) {},
+                        });
         }
+        return result;
     }
-
-    bool reader::read() noexcept
+    bool writer::write_files(const std::vector<content_node *> &nodes) noexcept
     {
-        if (_errors.size() > 0)
-            return false;
-
-        for (auto &[path, src] : _sources)
+        std::string content;
+        for (auto node : nodes)
         {
-            if (!read(path, src))
-                break;
+            if (!write_node(content, node))
+                return false;
         }
-        return _errors.size() == 0;
+        add_file(path, std::move(content));
+        return true;
     }
-    void reader::clear() noexcept
+    bool writer::render(const std::vector<content_node *> &nodes) noexcept
     {
+        stopwatch watch(&(_time = {}));
+        _files.clear();
         _errors.clear();
-        for (auto node : _nodes)
-            node->free();
-        _nodes.clear();
-        _sources.clear();
+        if (_roots.size() > 0 && !reach(nodes))
+            return false;
+        return write_files(nodes);
     }
+    bool writer::commit() noexcept
+    {
+        stopwatch watch(&_time);
+        auto result = true;
+        std::unordered_set<std::string> committed;
+        for (auto &file : _files)
+        {
+            file.written = false;
+            committed.insert(file.path);
 
-} // namespace anybuf
+            std::error_code error;
+            if (auto size = std::filesystem::file_size(file.path, error); !error && size == file.content.size())
+            {
+                mapping current;
+                if (current.open(file.path) && current.data() == file.content)
+                    continue;
+            }
 
-namespace anybuf
-{
+            // written beside and renamed, readers of the file never see a part of it
+            std::filesystem::create_directories(std::filesystem::path(file.path).parent_path(), error);
+            auto temp = std::filesystem::path(file.path).concat(".tmp");
+            if (std::ofstream stream(temp, std::ios::binary | std::ios::trunc); !stream.write(file.content.data(), file.content.size()))
+            {
+                _errors.push_back(file.path + ": open failed");
+                result = false;
+                continue;
+            }
+            std::filesystem::rename(temp, file.path, error);
+            if (error)
+            {
+                std::filesystem::remove(temp, error);
+                _errors.push_back(file.path + ": write failed");
+                result = false;
+                continue;
+            }
+            file.written = true;
+        }
+
+        for (auto &path : _committed)
+        {
+            std::error_code error;
+            if (committed.count(path) == 0)
+                std::filesystem::remove(path, error);
+        }
+        _committed.swap(committed);
+        return result;
+    }
+    bool writer::write(const std::vector<writer *> &writers, const std::vector<content_node *> &nodes) noexcept
+    {
+        // the nodes are only read, each writer has its own content
+        std::vector<char> results(writers.size());
+        work_pool::run(writers.size(), [&](std::size_t index, std::size_t) { results[index] = writers[index]->write(nodes); });
+        return std::find(results.begin(), results.end(), false) == results.end();
+    }
     writer *writer::create(std::string language, const std::string &path, const std::string &package) noexcept
     {
         while (language.size())
@@ -1008,171 +2944,884 @@ namespace anybuf
     }
 
 #pragma region C
-    bool c_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool c_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool c_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool c_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool c_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool c_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool c_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool c_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion C
 
 #pragma region C++
-    bool cpp_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    namespace
+    {
+        /** start of every file */
+        constexpr const char *cpp_banner = "// generated by anybuf, don't edit\n";
+        /** standard headers of the declarations */
+        constexpr const char *cpp_includes = "#include <cstdint>\n"
+                                             "#include <map>\n"
+                                             "#include <optional>\n"
+                                             "#include <string>\n"
+                                             "#include <string_view>\n"
+                                             "#include <tuple>\n"
+                                             "#include <vector>\n";
+        /** runtime of the encode and decode, the header ships with anybuf */
+        constexpr const char *cpp_runtime = "#include \"anybuf_rt.hpp\"\n";
+        /** keywords and alternative tokens of C++20, and std, which a member would hide from the types after it */
+        constexpr std::string_view cpp_reserved[] = {
+            "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+            "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval", "constexpr",
+            "constinit", "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default", "delete",
+            "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+            "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+            "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+            "requires", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+            "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
+            "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq", "std"};
+        /** members of a struct besides its fields */
+        constexpr std::string_view cpp_struct_members[] = {"encode", "decode", "max_encoded_size", "allocator_type", "get_allocator"};
+
+        const char *cpp_type(identity format) noexcept
+        {
+            switch (format)
+            {
+            case identity::u8:
+                return "std::uint8_t";
+            case identity::u16:
+                return "std::uint16_t";
+            case identity::u32:
+                return "std::uint32_t";
+            case identity::u64:
+                return "std::uint64_t";
+            case identity::i8:
+                return "std::int8_t";
+            case identity::i16:
+                return "std::int16_t";
+            case identity::i32:
+                return "std::int32_t";
+            case identity::i64:
+                return "std::int64_t";
+            case identity::f32:
+                return "float";
+            case identity::f64:
+                return "double";
+            case identity::boolean:
+                return "bool";
+            case identity::str:
+                return "std::string";
+            default:
+                return nullptr;
+            }
+        }
+        /** fields of the struct in index order, the order they are encoded in */
+        std::vector<estruct_member_node *> sorted_fields(const estruct_node *node)
+        {
+            std::vector<estruct_member_node *> fields;
+            for (auto member : node->members)
+            {
+                if (member->type() == node_type::estruct_member)
+                    fields.push_back(static_cast<estruct_member_node *>(member));
+            }
+            std::sort(fields.begin(), fields.end(), [](auto a, auto b) { return a->index < b->index; });
+            return fields;
+        }
+        /** path of the include from the file, both relative to the same directory */
+        std::string include_path(const std::string &from, const std::string &include)
+        {
+            return std::filesystem::path(include).lexically_relative(std::filesystem::path(from).parent_path()).generic_string();
+        }
+    } // namespace
+
+    std::string cpp_writer::name(const content_node *node) const
+    {
+        std::string name;
+        for (auto text : {std::string_view(package), node ? node->qualified_name : std::string_view()})
+        {
+            if (text.size() == 0)
+                continue;
+            if (name.size() > 0)
+                name += "::";
+            for (auto ch : text)
+                ch == '.' ? name += "::" : name += ch;
+        }
+        return name;
+    }
+    bool cpp_writer::check_name(const content_node *node)
+    {
+        auto error = [&](const char *reason) {
+            _errors.push_back(path + ": " + std::string(node->qualified_name) + " " + reason);
+            return false;
+        };
+        auto contains = [&](auto &names) { return std::find(std::begin(names), std::end(names), node->name) != std::end(names); };
+        if (contains(cpp_reserved))
+            return error("is reserved in C++");
+        if (node->name.substr(0, 7) == "anybuf_")
+            return error("is reserved for the generated code");
+
+        // a field can't take the name of a member or of the view of its struct, nor any declaration the name of a view next to it
+        auto field = node->type() == node_type::estruct_member;
+        if (field && (node->name == node->parent->name || contains(cpp_struct_members)))
+            return error("conflicts with a member of the generated struct");
+        auto suffix = std::string_view("_view");
+        if (node->name.size() > suffix.size() && node->name.substr(node->name.size() - suffix.size()) == suffix)
+        {
+            auto qualified = node->qualified_name.substr(0, node->qualified_name.size() - suffix.size());
+            if (_structs.count(qualified) > 0 || (field && node->name.substr(0, node->name.size() - suffix.size()) == node->parent->name))
+                return error("conflicts with the view of a struct");
+        }
+        return true;
+    }
+    void cpp_writer::write_comment(std::string &output, const content_node *node) const
+    {
+        if (node->comment.size() > 0)
+            output.append(_indent * 4, ' ').append(node->comment) += '\n';
+    }
+    bool cpp_writer::write_type(std::string &output, type_node *node) noexcept
+    {
+        if (auto type = cpp_type(node->format); type)
+        {
+            output += _pmr && node->format == identity::str ? "std::pmr::string" : type;
+            return true;
+        }
+
+        switch (node->format)
+        {
+        case identity::eenum:
+        case identity::estruct:
+            output += "::" + name(static_cast<content_node *>(node->values[0]));
+            return true;
+        case identity::array:
+            output += _pmr ? "std::pmr::vector<" : "std::vector<";
+            break;
+        case identity::tuple:
+            output += "std::tuple<";
+            break;
+        case identity::map:
+            output += _pmr ? "std::pmr::map<" : "std::map<";
+            break;
+        default:
+            _errors.push_back(path + ": invaild type");
+            return false;
+        }
+        for (std::size_t i = 0; i < node->values.size(); ++i)
+        {
+            if (i > 0)
+                output += ", ";
+            if (!write_type(output, static_cast<type_node *>(node->values[i])))
+                return false;
+        }
+        output += '>';
+        return true;
+    }
+    bool cpp_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        if (!check_name(node))
+            return false;
+        write_comment(output, node);
+        output += "namespace " + std::string(node->name) + "\n{\n";
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
+        output += "} // namespace " + std::string(node->name) + "\n";
         return true;
     }
-    bool cpp_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool cpp_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
+        if (!check_name(node))
+            return false;
+        std::string indent(_indent * 4, ' ');
+        write_comment(output, node);
+        output += indent + "enum class " + std::string(node->name) + " : " + cpp_type(node->format) + "\n" + indent + "{\n";
+        ++_indent;
+        for (auto member : node->members)
+        {
+            if (!check_name(member))
+                return false;
+            write_comment(output, member);
+            output += indent + "    " + std::string(member->name) + " = " + std::to_string(member->value) + ",\n";
+        }
+        --_indent;
+        output += indent + "};\n" + (_indent == 0 ? "\n" : "");
         return true;
     }
-    bool cpp_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool cpp_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
+        if (!check_name(node))
+            return false;
+        std::string indent(_indent * 4, ' ');
+        output += indent + "class " + std::string(node->name) + "_view;\n";
+        write_comment(output, node);
+        output += indent + "struct " + std::string(node->name);
+        auto bases = direct_bases(node);
+        for (std::size_t i = 0; i < bases.size(); ++i)
+            output += (i == 0 ? " : ::" : ", ::") + name(bases[i]);
+        output += "\n" + indent + "{\n";
+
+        ++_indent;
+        for (auto member : node->members)
+        {
+            if (member->type() != node_type::estruct_member)
+            {
+                if (!write_node(output, member))
+                    return false;
+                continue;
+            }
+
+            auto field = static_cast<estruct_member_node *>(member);
+            if (!check_name(field))
+                return false;
+            write_comment(output, field);
+            output += indent + "    " + (field->optional ? "std::optional<" : "");
+            if (!write_type(output, field->format))
+                return false;
+            output += std::string(field->optional ? ">" : "") + " " + std::string(field->name) + "{};\n";
+        }
+        --_indent;
+
+        // an allocator for every member, and the members of a copy or a move, as pmr containers take one
+        auto struct_name = std::string(node->name);
+        if (_pmr)
+            output += "\n" +
+                      indent + "    using allocator_type = std::pmr::polymorphic_allocator<char>;\n" +
+                      indent + "    " + struct_name + "() = default;\n" +
+                      indent + "    explicit " + struct_name + "(const allocator_type &anybuf_allocator);\n" +
+                      indent + "    " + struct_name + "(const " + struct_name + " &anybuf_other, const allocator_type &anybuf_allocator);\n" +
+                      indent + "    " + struct_name + "(" + struct_name + " &&anybuf_other, const allocator_type &anybuf_allocator);\n" +
+                      indent + "    allocator_type get_allocator() const noexcept { return anybuf_allocator.get(); }\n";
+
+        // a bounded struct gives its largest encoding, an unbounded one hides the bound of its bases
+        auto size = _sizes.size(node);
+        if (size.bounded)
+            output += "\n" + indent + "    static constexpr std::size_t max_encoded_size = " + std::to_string(size.max) + ";\n";
+        else if (bases.size() > 0)
+            output += "\n" + indent + "    static constexpr std::size_t max_encoded_size = SIZE_MAX; // unbounded\n";
+        output += "\n" +
+                  indent + "    template <typename Sink>\n" +
+                  indent + "    void encode(Sink &anybuf_out) const;\n" +
+                  indent + "    bool decode(std::string_view &anybuf_in);\n" +
+                  "\n" +
+                  indent + "    using anybuf_view = ::" + name(node) + "_view;\n";
+        if (_pmr)
+            output += "\n" +
+                      indent + "private:\n" +
+                      indent + "    anybuf_rt::pmr_allocator anybuf_allocator;\n";
+        output += indent + "};\n";
+
+        // the view reads the encoded struct in place, the fields after the bases are checked as it is constructed
+        // its accessors are the fields, anybuf_rt::valid and anybuf_rt::size read the rest through view_access
+        auto view = std::string(node->name) + "_view";
+        output += indent + "class " + view;
+        for (std::size_t i = 0; i < bases.size(); ++i)
+            output += (i == 0 ? " : public ::" : ", public ::") + name(bases[i]) + "_view";
+        output += "\n" + indent + "{\n" +
+                  indent + "protected:\n" +
+                  indent + "    std::string_view anybuf_fields;\n" +
+                  indent + "    std::size_t anybuf_size = 0;\n" +
+                  "\n" +
+                  indent + "public:\n" +
+                  indent + "    " + view + "() noexcept = default;\n" +
+                  indent + "    explicit " + view + "(std::string_view anybuf_data) noexcept;\n" +
+                  "\n";
+        for (auto member : node->members)
+        {
+            if (member->type() == node_type::estruct_member)
+            {
+                auto field = static_cast<estruct_member_node *>(member);
+                output += indent + "    std::optional<" + view_type(field->format) + "> " + std::string(field->name) + "() const noexcept;\n";
+            }
+        }
+        output += "\n" +
+                  indent + "protected:\n" +
+                  indent + "    static bool anybuf_skip(std::string_view &anybuf_in) noexcept;\n" +
+                  indent + "    static const anybuf_rt::skip_table &anybuf_skips() noexcept;\n" +
+                  "\n" +
+                  indent + "    friend struct anybuf_rt::view_access;\n" +
+                  indent + "};\n" + (_indent == 0 ? "\n" : "");
         return true;
     }
-    bool cpp_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    void cpp_writer::write_encode(std::string &output, estruct_node *node) const
+    {
+        // the bases another base doesn't derive from, then the count of the present fields and each field after its index, in index order
+        // the names of the generated code are reserved, the fields are read through this
+        output += "\ntemplate <typename Sink>\nvoid " + name(node) + "::encode(Sink &anybuf_out) const\n{\n";
+        for (auto base : direct_bases(node))
+            output += "    ::" + name(base) + "::encode(anybuf_out);\n";
+        auto fields = sorted_fields(node);
+        std::size_t required = 0;
+        for (auto field : fields)
+            required += field->optional ? 0 : 1;
+        output += "    std::uint64_t anybuf_count = " + std::to_string(required) + ";\n";
+        for (auto field : fields)
+        {
+            if (field->optional)
+                output += "    if (this->" + std::string(field->name) + ")\n        ++anybuf_count;\n";
+        }
+        output += "    anybuf_rt::put_varint(anybuf_out, anybuf_count);\n";
+        for (auto field : fields)
+        {
+            auto index = std::to_string(field->index);
+            auto member = "this->" + std::string(field->name);
+            if (field->optional)
+                output += "    if (" + member + ")\n    {\n" +
+                          "        anybuf_out.push_back(static_cast<char>(" + index + "));\n" +
+                          "        anybuf_rt::put(anybuf_out, *" + member + ");\n    }\n";
+            else
+                output += "    anybuf_out.push_back(static_cast<char>(" + index + "));\n" +
+                          "    anybuf_rt::put(anybuf_out, " + member + ");\n";
+        }
+        output += "}\n";
+
+        for (auto member : node->members)
+        {
+            if (member->type() == node_type::estruct && reached(member))
+                write_encode(output, static_cast<estruct_node *>(member));
+        }
+    }
+    void cpp_writer::write_decode(std::string &output, estruct_node *node, const char *specifier) const
+    {
+        auto struct_name = name(node);
+        output += std::string("\n") + specifier + "bool " + struct_name + "::decode(std::string_view &anybuf_in)\n{\n";
+        for (auto base : direct_bases(node))
+            output += "    if (!::" + name(base) + "::decode(anybuf_in))\n        return false;\n";
+        output += "    std::uint64_t anybuf_count = 0;\n"
+                  "    if (!anybuf_rt::get_varint(anybuf_in, anybuf_count))\n"
+                  "        return false;\n";
+
+        // the fields in the index order they are encoded in, then the rest out of order by a table of the indices
+        auto fields = sorted_fields(node);
+        // an optional field is made with the allocator of the struct in pmr mode
+        auto target = [this](estruct_member_node *field, const std::string &object) {
+            auto member = object + std::string(field->name);
+            if (!field->optional)
+                return member;
+            return _pmr ? "anybuf_rt::emplace(" + member + ", " + object + "get_allocator())" : member + ".emplace()";
+        };
+        for (auto field : fields)
+            output += "    if (anybuf_rt::next_field(anybuf_in, anybuf_count, " + std::to_string(field->index) + ") && !anybuf_rt::get(anybuf_in, " +
+                      target(field, "this->") + "))\n        return false;\n";
+        if (fields.size() == 0)
+            output += "    return anybuf_count == 0;\n}\n";
+        else
+        {
+            output += "    if (anybuf_count == 0)\n        return true;\n"
+                      "    static constexpr anybuf_rt::field_table<::" + struct_name + "> anybuf_table = anybuf_rt::make_field_table<::" + struct_name + ">({\n";
+            for (auto field : fields)
+                output += "        {" + std::to_string(field->index) + ", [](::" + struct_name + " &value, std::string_view &in) { return anybuf_rt::get(in, " +
+                          target(field, "value.") + "); }},\n";
+            output += "    });\n"
+                      "    return anybuf_rt::get_fields(anybuf_in, *this, anybuf_count, anybuf_table);\n"
+                      "}\n";
+        }
+
+        for (auto member : node->members)
+        {
+            if (member->type() == node_type::estruct && reached(member))
+                write_decode(output, static_cast<estruct_node *>(member), specifier);
+        }
+    }
+    void cpp_writer::write_constructors(std::string &output, estruct_node *node, const char *specifier) const
+    {
+        auto struct_name = name(node);
+        auto bases = direct_bases(node);
+        std::vector<std::string> fields;
+        for (auto member : node->members)
+        {
+            if (member->type() == node_type::estruct_member)
+                fields.push_back(std::string(member->name));
+        }
+
+        // the bases and the members in declaration order, each made with the allocator from the same member of the other
+        auto constructor = [&](const std::string &parameters, const std::string &other) {
+            output += std::string("\n") + specifier + struct_name + "::" + std::string(node->name) + "(" + parameters + ")";
+            auto separator = "\n    : ";
+            for (auto base : bases)
+            {
+                output += separator + ("::" + name(base)) + "(" + (other.size() > 0 ? other + ", " : "") + "anybuf_allocator)";
+                separator = ",\n      ";
+            }
+            for (auto &field : fields)
+            {
+                auto from = other.size() == 0 ? "" : other == "anybuf_other" ? ", anybuf_other." + field : ", std::move(anybuf_other." + field + ")";
+                output += separator + field + "(anybuf_rt::make<decltype(this->" + field + ")>(anybuf_allocator" + from + "))";
+                separator = ",\n      ";
+            }
+            output += std::string(separator) + "anybuf_allocator(anybuf_allocator)\n{\n}\n";
+        };
+        // a struct without bases and fields doesn't name the other
+        auto other = bases.size() + fields.size() > 0 ? "anybuf_other" : "";
+        constructor("const allocator_type &anybuf_allocator", "");
+        constructor("const " + std::string(node->name) + " &" + other + ", const allocator_type &anybuf_allocator", "anybuf_other");
+        constructor(std::string(node->name) + " &&" + other + ", const allocator_type &anybuf_allocator", "std::move(anybuf_other)");
+
+        for (auto member : node->members)
+        {
+            if (member->type() == node_type::estruct && reached(member))
+                write_constructors(output, static_cast<estruct_node *>(member), specifier);
+        }
+    }
+    std::string cpp_writer::view_type(type_node *node)
+    {
+        if (auto type = cpp_type(node->format); type)
+            return node->format == identity::str ? "std::string_view" : type;
+
+        std::string type;
+        switch (node->format)
+        {
+        case identity::eenum:
+            return "::" + name(static_cast<content_node *>(node->values[0]));
+        case identity::estruct:
+            return "::" + name(static_cast<content_node *>(node->values[0])) + "_view";
+        case identity::array:
+            write_type(type, static_cast<type_node *>(node->values[0]));
+            return "anybuf_rt::array_view<" + type + ">";
+        case identity::map:
+            write_type(type, static_cast<type_node *>(node->values[0]));
+            type += ", ";
+            write_type(type, static_cast<type_node *>(node->values[1]));
+            return "anybuf_rt::map_view<" + type + ">";
+        default:
+            type = "std::tuple<";
+            for (std::size_t i = 0; i < node->values.size(); ++i)
+                type += (i > 0 ? ", " : "") + view_type(static_cast<type_node *>(node->values[i]));
+            return type + ">";
+        }
+    }
+    void cpp_writer::write_view(std::string &output, estruct_node *node)
     {
+        auto view = name(node) + "_view";
+        auto bases = direct_bases(node);
+
+        // each base reads the data after the ones before it
+        output += "\ninline " + view + "::" + std::string(node->name) + "_view(std::string_view anybuf_data) noexcept";
+        std::string offset;
+        for (std::size_t i = 0; i < bases.size(); ++i)
+        {
+            output += std::string(i == 0 ? "\n    : " : ",\n      ") + "::" + name(bases[i]) + "_view(anybuf_data" + (i == 0 ? "" : ".substr(" + offset + ")") + ")";
+            offset += (i == 0 ? "" : " + ") + std::string("::") + name(bases[i]) + "_view::anybuf_size";
+        }
+        output += "\n{\n";
+        if (bases.size() > 0)
+        {
+            output += "    if (";
+            for (std::size_t i = 0; i < bases.size(); ++i)
+                output += (i == 0 ? "::" : " || ::") + name(bases[i]) + "_view::anybuf_size == 0";
+            output += ")\n        return;\n";
+        }
+        output += "    auto anybuf_in = anybuf_data" + (bases.size() > 0 ? ".substr(" + offset + ")" : std::string()) + ";\n" +
+                  "    auto anybuf_begin = anybuf_in;\n"
+                  "    if (!anybuf_rt::skip_fields(anybuf_in, anybuf_skips()))\n"
+                  "        return;\n"
+                  "    anybuf_fields = anybuf_begin.substr(0, anybuf_begin.size() - anybuf_in.size());\n"
+                  "    anybuf_size = anybuf_data.size() - anybuf_in.size();\n"
+                  "}\n";
+
+        std::vector<std::pair<estruct_member_node *, std::string>> fields;
+        for (auto field : sorted_fields(node))
+        {
+            std::string type;
+            write_type(type, field->format);
+            fields.emplace_back(field, type);
+        }
+        for (auto &[field, type] : fields)
+            output += "inline std::optional<" + view_type(field->format) + "> " + view + "::" + std::string(field->name) + "() const noexcept\n{\n" +
+                      "    return anybuf_rt::field<" + type + ">(anybuf_fields, " + std::to_string(field->index) + ", anybuf_skips());\n}\n";
+
+        output += "inline bool " + view + "::anybuf_skip(std::string_view &anybuf_in) noexcept\n{\n    return ";
+        for (auto base : bases)
+            output += "::" + name(base) + "_view::anybuf_skip(anybuf_in) && ";
+        output += "anybuf_rt::skip_fields(anybuf_in, anybuf_skips());\n}\n";
+
+        output += "inline const anybuf_rt::skip_table &" + view + "::anybuf_skips() noexcept\n{\n";
+        if (fields.size() == 0)
+            output += "    static constexpr anybuf_rt::skip_table table{};\n";
+        else
+        {
+            output += "    static constexpr anybuf_rt::skip_table table = anybuf_rt::make_skip_table({\n";
+            for (auto &[field, type] : fields)
+                output += "        {" + std::to_string(field->index) + ", &anybuf_rt::wire<" + type + ">::skip},\n";
+            output += "    });\n";
+        }
+        output += "    return table;\n}\n";
+
+        for (auto member : node->members)
+        {
+            if (member->type() == node_type::estruct && reached(member))
+                write_view(output, static_cast<estruct_node *>(member));
+        }
+    }
+    bool cpp_writer::write_files(const std::vector<content_node *> &nodes) noexcept
+    {
+        _indent = 0;
+        _sizes.clear();
+        _structs.clear();
+        auto declared = [this](content_node *node, auto &declared) -> void {
+            visit(node, overloaded{
+                            [&](emodule_node *node) {
+                                for (auto member : node->members)
+                                    declared(member, declared);
+                            },
+                            [&](estruct_node *node) {
+                                _structs.insert(node->qualified_name);
+                                for (auto member : node->members)
+                                    declared(member, declared);
+                            },
+                            [](anybuf::node *) {},
+                        });
+        };
+        for (auto node : nodes)
+            declared(node, declared);
+        auto open_package = package.size() > 0 ? "namespace " + name(nullptr) + "\n{\n" : std::string();
+        auto close_package = package.size() > 0 ? "} // namespace " + name(nullptr) + "\n" : std::string();
+
+        // structs outside structs, in the order of the nodes
+        auto structs = [this](content_node *node, std::vector<estruct_node *> &structs, auto &collect) -> void {
+            if (!reached(node))
+                return;
+            if (node->type() == node_type::estruct)
+                structs.push_back(static_cast<estruct_node *>(node));
+            else if (node->type() == node_type::emodule)
+            {
+                for (auto member : static_cast<emodule_node *>(node)->members)
+                    collect(member, structs, collect);
+            }
+        };
+
+        if (_split == split_type::none)
+        {
+            auto content = std::string(cpp_banner) + "#pragma once\n\n" + cpp_includes + "\n" + cpp_runtime + "\n" + open_package;
+            std::vector<estruct_node *> definitions;
+            for (auto node : nodes)
+            {
+                if (!write_node(content, node))
+                    return false;
+                structs(node, definitions, structs);
+            }
+            content += close_package;
+            for (auto node : definitions)
+            {
+                if (_pmr)
+                    write_constructors(content, node, "inline ");
+                write_encode(content, node), write_decode(content, node, "inline "), write_view(content, node);
+            }
+            add_file(path, std::move(content));
+            return true;
+        }
+
+        auto directory = std::filesystem::path(path).parent_path();
+        auto stem = std::filesystem::path(path).stem().string();
+        auto file = [&](const std::string &name) { return (directory / name).string(); };
+
+        // the file of a node without its extension, after its top level module or its declaration
+        auto unit = [&](const content_node *node) {
+            while (node->parent && (_split == split_type::emodule || node->parent->type() != node_type::emodule))
+                node = node->parent;
+            std::string name = stem + '/';
+            for (auto ch : node->qualified_name)
+                name += ch == '.' ? '/' : ch;
+            return name;
+        };
+        std::vector<std::string> units;
+        std::unordered_map<std::string, std::vector<content_node *>> members;
+        auto collect = [&](content_node *node, auto &collect) -> void {
+            if (!reached(node))
+                return;
+            if (node->type() == node_type::emodule && _split == split_type::declaration)
+            {
+                for (auto member : static_cast<emodule_node *>(node)->members)
+                    collect(member, collect);
+                return;
+            }
+            // a module may be split over several sources
+            auto &unit_members = members[unit(node)];
+            if (unit_members.size() == 0)
+                units.push_back(unit(node));
+            unit_members.push_back(node);
+        };
+        for (auto node : nodes)
+            collect(node, collect);
+
+        auto forward = std::string(cpp_banner) + "#pragma once\n\n#include <cstdint>\n\n" + open_package;
+        auto declare = [&](content_node *node, auto &declare) -> void {
+            if (!reached(node))
+                return;
+            visit(node, overloaded{
+                            [&](emodule_node *node) {
+                                forward += "namespace " + std::string(node->name) + "\n{\n";
+                                for (auto member : node->members)
+                                    declare(member, declare);
+                                forward += "} // namespace " + std::string(node->name) + "\n";
+                            },
+                            [&](eenum_node *node) { forward += "enum class " + std::string(node->name) + " : " + cpp_type(node->format) + ";\n"; },
+                            [&](estruct_node *node) { forward += "struct " + std::string(node->name) + ";\nclass " + std::string(node->name) + "_view;\n"; },
+                            [](anybuf::node *) {},
+                        });
+        };
+        for (auto node : nodes)
+            declare(node, declare);
+        add_file(file(stem + "_fwd.hpp"), std::move(forward += close_package));
+
+        auto all = std::string(cpp_banner) + "#pragma once\n\n";
+        for (auto &name : units)
+        {
+            auto header = name + ".hpp";
+            all += "#include \"" + include_path(stem + ".hpp", header) + "\"\n";
+
+            // the files declaring the bases and member types of the structs
+            std::vector<estruct_node *> definitions;
+            std::set<std::string> includes;
+            auto depend = [&](anybuf::node *node, auto &depend) -> void {
+                visit(node, overloaded{
+                                [&](emodule_node *node) {
+                                    for (auto member : node->members)
+                                        depend(member, depend);
+                                },
+                                [&](estruct_node *node) {
+                                    for (auto base : node->bases)
+                                        includes.insert(unit(base));
+                                    for (auto member : node->members)
+                                        depend(member, depend);
+                                },
+                                [&](estruct_member_node *node) { depend(node->format, depend); },
+                                [&](type_node *node) {
+                                    if (node->format == identity::eenum || node->format == identity::estruct)
+                                        includes.insert(unit(static_cast<content_node *>(node->values[0])));
+                                    else
+                                    {
+                                        for (auto value : node->values)
+                                            depend(value, depend);
+                                    }
+                                },
+                                [](anybuf::node *) {},
+                            });
+            };
+            for (auto node : members[name])
+            {
+                depend(node, depend);
+                structs(node, definitions, structs);
+            }
+            includes.erase(name);
+
+            auto content = std::string(cpp_banner) + "#pragma once\n\n" + cpp_includes + "\n" + cpp_runtime;
+            for (auto &include : includes)
+                content += "#include \"" + include_path(header, include + ".hpp") + "\"\n";
+            content += '\n' + open_package;
+
+            // a declaration in the namespaces of its modules
+            std::vector<const content_node *> scopes;
+            for (auto scope = members[name][0]->parent; _split == split_type::declaration && scope; scope = scope->parent)
+                scopes.insert(scopes.begin(), scope);
+            for (auto scope : scopes)
+                content += "namespace " + std::string(scope->name) + "\n{\n";
+            for (auto node : members[name])
+            {
+                if (!write_node(content, node))
+                    return false;
+            }
+            for (auto i = scopes.size(); i > 0; --i)
+                content += "} // namespace " + std::string(scopes[i - 1]->name) + "\n";
+            content += close_package;
+            // encode is a template of the sink and the views are read inline, defined with the declarations
+            for (auto node : definitions)
+                write_encode(content, node), write_view(content, node);
+            add_file(file(header), std::move(content));
+
+            if (definitions.size() > 0)
+            {
+                auto source = std::string(cpp_banner) + "#include \"" + include_path(header, header) + "\"\n";
+                for (auto node : definitions)
+                {
+                    if (_pmr)
+                        write_constructors(source, node, "");
+                    write_decode(source, node, "");
+                }
+                add_file(file(name + ".cpp"), std::move(source));
+            }
+        }
+        add_file(path, std::move(all));
         return true;
     }
 #pragma endregion C++
 
 #pragma region CSharp
-    bool csharp_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool csharp_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool csharp_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool csharp_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool csharp_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool csharp_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool csharp_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool csharp_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion CSharp
 
 #pragma region Java
-    bool java_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool java_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool java_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool java_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool java_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool java_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool java_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool java_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion Java
 
 #pragma region Go
-    bool go_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool go_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool go_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool go_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool go_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool go_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool go_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool go_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion Go
 
 #pragma region Rust
-    bool rust_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool rust_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool rust_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool rust_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool rust_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool rust_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool rust_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool rust_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion Rust
 
 #pragma region Typescript
-    bool typescript_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool typescript_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool typescript_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool typescript_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool typescript_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool typescript_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool typescript_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool typescript_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion Typescript
 
 #pragma region Python
-    bool python_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool python_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool python_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool python_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool python_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool python_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool python_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool python_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
 #pragma endregion Python
 
 #pragma region Lua
-    bool lua_writer::write_type(std::ofstream &stream, type_node *node) noexcept
+    bool lua_writer::write_type(std::string &output, type_node *node) noexcept
     {
         return true;
     }
-    bool lua_writer::write_emodule(std::ofstream &stream, emodule_node *node) noexcept
+    bool lua_writer::write_emodule(std::string &output, emodule_node *node) noexcept
     {
+        for (auto member : node->members)
+        {
+            if (!write_node(output, member))
+                return false;
+        }
         return true;
     }
-    bool lua_writer::write_eenum(std::ofstream &stream, eenum_node *node) noexcept
+    bool lua_writer::write_eenum(std::string &output, eenum_node *node) noexcept
     {
         return true;
     }
-    bool lua_writer::write_estruct(std::ofstream &stream, estruct_node *node) noexcept
+    bool lua_writer::write_estruct(std::string &output, estruct_node *node) noexcept
     {
         return true;
     }
@@ -1,4 +1,6 @@
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -12,110 +14,256 @@ auto _ = [] { return SetConsoleOutputCP(CP_UTF8); }();
 
 void print_node(anybuf::node *node)
 {
-    auto path = [](anybuf::content_node *node) {
-        auto path = std::string(node->name);
-        for (auto parent = node->parent; parent != nullptr; parent = parent->parent)
-            path = std::string(parent->name) + "." + path;
-        return path;
-    };
+    anybuf::visit(node, anybuf::overloaded{
+                            [](anybuf::emodule_node *emodule) {
+                                std::cout << "module: " << emodule->qualified_name << std::endl;
+                                for (auto member : emodule->members)
+                                    print_node(member);
+                            },
+                            [](anybuf::estruct_node *estruct) {
+                                std::cout << "struct: " << estruct->qualified_name;
 
-    auto type = node->type();
-    if (type == anybuf::node_type::emodule)
-    {
-        auto emodule = dynamic_cast<anybuf::emodule_node *>(node);
-        std::cout << "module: " << path(emodule) << std::endl;
-        for (auto member : emodule->members)
-            print_node(member);
-    }
-    else if (type == anybuf::node_type::estruct)
-    {
-        auto estruct = dynamic_cast<anybuf::estruct_node *>(node);
-        std::cout << "struct: " << path(estruct);
+                                if (estruct->bases.size() > 0)
+                                    std::cout << " : ";
+                                for (auto i = 0; i < estruct->bases.size(); ++i)
+                                    std::cout << (i > 0 ? ", " : "") << estruct->bases[i]->qualified_name;
+                                std::cout << std::endl;
 
-        if (estruct->bases.size() > 0)
-            std::cout << " : ";
-        for (auto i = 0; i < estruct->bases.size(); ++i)
-            std::cout << (i > 0 ? ", " : "") << path(estruct->bases[i]);
-        std::cout << std::endl;
+                                for (auto member : estruct->members)
+                                    print_node(member);
 
-        for (auto member : estruct->members)
-            print_node(member);
+                                if (!estruct->parent || estruct->parent->type() != anybuf::node_type::estruct)
+                                    std::cout << std::endl;
+                            },
+                            [](anybuf::eenum_node *eenum) {
+                                std::cout << "enum: " << eenum->qualified_name << " : " << anybuf::keyword(eenum->format) << std::endl;
+                                for (auto member : eenum->members)
+                                    print_node(member);
 
-        if (!estruct->parent || estruct->parent->type() != anybuf::node_type::estruct)
-            std::cout << std::endl;
-    }
-    else if (type == anybuf::node_type::eenum)
-    {
-        auto eenum = dynamic_cast<anybuf::eenum_node *>(node);
-        std::cout << "enum: " << path(eenum) << " : " << anybuf::keyword(eenum->format) << std::endl;
-        for (auto member : eenum->members)
-            print_node(member);
+                                if (!eenum->parent || eenum->parent->type() != anybuf::node_type::estruct)
+                                    std::cout << std::endl;
+                            },
+                            [](anybuf::estruct_member_node *member) {
+                                std ::cout << member->qualified_name << (member->optional ? "?:" : ":") << (int)member->index << " ";
+                                print_node(member->format);
+                                std::cout << std::endl;
+                            },
+                            [](anybuf::eenum_member_node *member) {
+                                std ::cout << member->qualified_name << ": " << member->value << std::endl;
+                            },
+                            [](anybuf::type_node *type) {
+                                if (type->format == anybuf::identity::tuple)
+                                    std::cout << "[";
+                                else if (type->format == anybuf::identity::map)
+                                    std::cout << "<";
 
-        if (!eenum->parent || eenum->parent->type() != anybuf::node_type::estruct)
-            std::cout << std::endl;
-    }
-    else if (type == anybuf::node_type::estruct_member)
-    {
-        auto member = dynamic_cast<anybuf::estruct_member_node *>(node);
-        std ::cout << path(member) << (member->optional ? "?:" : ":") << (int)member->index << " ";
-        print_node(member->format);
-        std::cout << std::endl;
-    }
-    else if (type == anybuf::node_type::eenum_member)
+                                auto comma = false;
+                                for (auto node : type->values)
+                                {
+                                    if (comma)
+                                        std::cout << ", ";
+                                    comma = true;
+                                    if (node->type() == anybuf::node_type::type)
+                                        print_node(node);
+                                    else
+                                        std::cout << static_cast<anybuf::content_node *>(node)->qualified_name;
+                                }
+
+                                if (type->format == anybuf::identity::tuple)
+                                    std::cout << "]";
+                                else if (type->format == anybuf::identity::map)
+                                    std::cout << ">";
+                                else if (type->format == anybuf::identity::array)
+                                    std::cout << "[]";
+                                else if (type->format != anybuf::identity::eenum && type->format != anybuf::identity::estruct)
+                                    std::cout << anybuf::keyword(type->format);
+                            },
+                        });
+}
+
+void print_stats(const anybuf::reader &reader)
+{
+    auto ms = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+    auto &stats = reader.stats();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(48) << "file" << std::right << std::setw(10) << "tokens"
+              << std::setw(12) << "scan ms" << std::setw(12) << "read ms" << std::setw(12) << "resolve ms" << std::endl;
+    for (std::size_t i = 0; i < stats.files.size(); ++i)
     {
-        auto member = dynamic_cast<anybuf::eenum_member_node *>(node);
-        std ::cout << path(member) << ": " << member->value << std::endl;
+        auto &file = stats.files[i];
+        std::cout << std::left << std::setw(48) << reader.files()[i] << std::right << std::setw(10) << file.tokens
+                  << std::setw(12) << ms(file.scan) << std::setw(12) << ms(file.read) << std::setw(12) << ms(file.resolve)
+                  << (file.cached ? " cached" : "") << std::endl;
     }
-    else if (type == anybuf::node_type::type)
-    {
-        auto type = dynamic_cast<anybuf::type_node *>(node);
 
-        if (type->format == anybuf::identity::tuple)
-            std::cout << "[";
-        else if (type->format == anybuf::identity::map)
-            std::cout << "<";
+    const char *names[] = {"type", "module", "enum", "enum member", "struct", "struct member"};
+    std::cout << "nodes:";
+    for (std::size_t i = 0; i < stats.nodes.size(); ++i)
+        std::cout << (i > 0 ? ", " : " ") << names[i] << ' ' << stats.nodes[i];
+    std::cout << std::endl
+              << "memory: " << stats.memory << " bytes" << std::endl;
+}
 
-        auto comma = false;
-        for (auto node : type->values)
+void print_sizes(const anybuf::reader &reader)
+{
+    anybuf::size_table sizes;
+    auto walk = [&sizes](anybuf::content_node *node, auto &walk) -> void {
+        if (node->type() == anybuf::node_type::estruct)
+        {
+            auto size = sizes.size(static_cast<anybuf::estruct_node *>(node));
+            std::cout << node->qualified_name << ": " << size.min << ".." << (size.bounded ? std::to_string(size.max) : "unbounded") << " bytes" << std::endl;
+        }
+        if (node->type() == anybuf::node_type::emodule)
+        {
+            for (auto member : static_cast<anybuf::emodule_node *>(node)->members)
+                walk(member, walk);
+        }
+        else if (node->type() == anybuf::node_type::estruct)
         {
-            if (comma)
-                std::cout << ", ";
-            comma = true;
-            if (node->type() == anybuf::node_type::type)
-                print_node(node);
-            else
-                std::cout << path(dynamic_cast<anybuf::content_node *>(node));
+            for (auto member : static_cast<anybuf::estruct_node *>(node)->members)
+                walk(member, walk);
         }
+    };
+    for (auto node : reader.nodes())
+        walk(node, walk);
+}
 
-        if (type->format == anybuf::identity::tuple)
-            std::cout << "]";
-        else if (type->format == anybuf::identity::map)
-            std::cout << ">";
-        else if (type->format == anybuf::identity::array)
-            std::cout << "[]";
-        else if (type->format != anybuf::identity::eenum && type->format != anybuf::identity::estruct)
-            std::cout << anybuf::keyword(type->format);
-    }
+/** extension of the files of the language */
+std::string extension(const std::string &language)
+{
+    static const std::map<std::string, std::string> extensions = {
+        {"c", "h"}, {"cpp", "hpp"}, {"c++", "hpp"}, {"csharp", "cs"}, {"c#", "cs"}, {"java", "java"}, {"go", "go"},
+        {"rust", "rs"}, {"ts", "ts"}, {"typescript", "ts"}, {"js", "js"}, {"javascript", "js"}, {"python", "py"}, {"lua", "lua"}};
+    auto iter = extensions.find(language);
+    return iter != extensions.end() ? iter->second : language;
 }
 
 int main(int argc, char **argv)
 {
     anybuf::reader reader;
+    bool watch = false;
+    bool stats = false;
+    bool lint = false;
+    bool sizes = false;
+    bool pmr = false;
+    std::string compile;
+    std::vector<std::string> languages;
+    std::vector<std::string> roots;
+    auto split = anybuf::writer::split_type::none;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--cache" && i + 1 < argc)
+            reader.cache(argv[++i]);
+        else if (std::string(argv[i]) == "--watch")
+            watch = true;
+        else if (std::string(argv[i]) == "--compile" && i + 1 < argc)
+            compile = argv[++i];
+        else if (std::string(argv[i]) == "--stats")
+            stats = true;
+        else if (std::string(argv[i]) == "--lint")
+            lint = true;
+        else if (std::string(argv[i]) == "--sizes")
+            sizes = true;
+        else if (std::string(argv[i]) == "--pmr")
+            pmr = true;
+        else if (std::string(argv[i]) == "--language" && i + 1 < argc)
+            languages.push_back(argv[++i]);
+        else if (std::string(argv[i]) == "--root" && i + 1 < argc)
+            roots.push_back(argv[++i]);
+        else if (std::string(argv[i]) == "--split" && i + 1 < argc)
+        {
+            auto type = std::string(argv[++i]);
+            split = type == "module" ? anybuf::writer::split_type::emodule : type == "declaration" ? anybuf::writer::split_type::declaration : anybuf::writer::split_type::none;
+        }
+    }
+    if (languages.empty())
+        languages.push_back("cpp");
+    reader.measure(stats);
+
+    // the writers are kept for the rebuilds, an output with the same bytes isn't written again
+    std::vector<anybuf::writer *> writers;
+    for (auto iter = languages.begin(); iter != languages.end();)
+    {
+        if (auto writer = anybuf::writer::create(*iter, "../doc/example." + extension(*iter)); writer)
+        {
+            writer->roots(roots);
+            writer->split(split);
+            if (auto cpp = dynamic_cast<anybuf::cpp_writer *>(writer); cpp)
+                cpp->pmr(pmr);
+            writers.push_back(writer);
+            ++iter;
+        }
+        else
+        {
+            std::cout << "unknown language " << *iter << std::endl;
+            iter = languages.erase(iter);
+        }
+    }
+
+    auto write = [&reader, &writers, &languages, &compile, stats, lint, sizes](bool result) {
+        if (stats)
+            print_stats(reader);
+        if (result)
+        {
+            if (lint)
+            {
+                for (auto const &warning : reader.lint())
+                    std::cout << "warning: " << warning << std::endl;
+            }
+            if (sizes)
+                print_sizes(reader);
+            anybuf::writer::write(writers, reader.nodes());
+            for (std::size_t i = 0; i < writers.size(); ++i)
+            {
+                for (auto const &error : writers[i]->errors())
+                    std::cout << error << std::endl;
+                if (stats)
+                    std::cout << "write " << languages[i] << ": " << std::chrono::duration<double, std::milli>(writers[i]->elapsed()).count() << " ms"
+                              << (writers[i]->written() ? "" : ", unchanged") << std::endl;
+            }
+            if (!compile.empty() && !anybuf::schema::write(compile, reader))
+                std::cout << "can't write " << compile << std::endl;
+        }
+        else
+        {
+            for (auto const &error : reader.errors())
+                std::cout << error << std::endl;
+        }
+    };
+
     reader.load("../doc");
-    if (reader.read())
+    auto result = reader.read();
+    if (result)
     {
-        auto const &nodes = reader.nodes();
-        for (auto const node : nodes)
+        for (auto const node : reader.nodes())
             print_node(node);
-
-        auto writer = anybuf::writer::create("cpp", "../doc/example.hpp");
-        writer->write(nodes);
-        anybuf::writer::destroy(writer);
     }
-    else
+    write(result);
+
+    if (watch)
     {
-        for (auto const &error : reader.errors())
-            std::cout << error << std::endl;
+        anybuf::watcher watcher;
+        if (!watcher.watch("../doc"))
+        {
+            std::cout << "can't watch ../doc" << std::endl;
+            for (auto writer : writers)
+                anybuf::writer::destroy(writer);
+            return 1;
+        }
+        while (true)
+        {
+            watcher.wait();
+            // the AST stays in memory, only changed sources and their importers are read again
+            auto failed = !result;
+            result = reader.reload();
+            if (result && !failed && reader.changed().empty())
+                continue;
+            for (auto const &path : reader.changed())
+                std::cout << "changed: " << path << std::endl;
+            write(result);
+        }
     }
+    for (auto writer : writers)
+        anybuf::writer::destroy(writer);
     return 0;
 }
@@ -0,0 +1,38 @@
+#include <iostream>
+#include <string>
+
+#include "anybuf.hpp"
+
+/** anybuf_generate <output> [--pmr] <path>...: the C++ of the schemas, for the tests to compile */
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: anybuf_generate <output> [--pmr] <path>..." << std::endl;
+        return 1;
+    }
+
+    anybuf::reader reader;
+    auto pmr = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--pmr")
+            pmr = true;
+        else
+            reader.load(argv[i]);
+    }
+    if (!reader.read())
+    {
+        for (auto const &error : reader.errors())
+            std::cout << error << std::endl;
+        return 1;
+    }
+
+    auto writer = static_cast<anybuf::cpp_writer *>(anybuf::writer::create("cpp", argv[1]));
+    writer->pmr(pmr);
+    auto result = anybuf::writer::write({writer}, reader.nodes());
+    for (auto const &error : writer->errors())
+        std::cout << error << std::endl;
+    anybuf::writer::destroy(writer);
+    return result ? 0 : 1;
+}
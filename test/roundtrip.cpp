@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "example.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool result, const char *expression, int line)
+    {
+        if (!result)
+        {
+            std::printf("roundtrip.cpp:%d: %s\n", line, expression);
+            ++failures;
+        }
+    }
+#define CHECK(expression) check(expression, #expression, __LINE__)
+
+    /** a struct of doc/example.anybuf with every kind of member */
+    example::struct3 make_struct3()
+    {
+        example::struct3 value;
+        auto &base = static_cast<example::struct1 &>(value);
+        base.p1 = -5;
+        base.p4 = -1234567890123;
+        base.p6 = 700;
+        base.p8 = UINT64_MAX;
+        base.p10 = 0.25;
+        base.p11 = true;
+        value.p11 = "hi";
+        std::get<0>(value.p12) = {1, 2, 3};
+        std::get<1>(value.p12) = 1.5f;
+        value.p13.emplace(1, "a");
+        value.p13.emplace(2, "b");
+        value.p14 = example::enum1::p3;
+        value.p15.emplace_back("x");
+        value.p15.emplace_back("yy");
+        value.p16.emplace_back(-1, 2.f);
+        value.p17.emplace_back();
+        value.p17.back().emplace(3, "c");
+        value.p18.emplace_back();
+        value.p18.back().emplace(example::struct3::xyz{}, 4);
+        return value;
+    }
+    void check_struct3(const example::struct3 &value)
+    {
+        auto &base = static_cast<const example::struct1 &>(value);
+        CHECK(base.p1 == -5);
+        CHECK(base.p4 == -1234567890123);
+        CHECK(base.p6 == 700);
+        CHECK(base.p8 == UINT64_MAX);
+        CHECK(base.p10 == 0.25);
+        CHECK(base.p11 == true);
+        CHECK(value.p11 == "hi");
+        CHECK(std::get<0>(value.p12).size() == 3 && std::get<0>(value.p12)[2] == 3 && std::get<1>(value.p12) == 1.5f);
+        CHECK(value.p13.size() == 2 && value.p13.at(2) == "b");
+        CHECK(value.p14 == example::enum1::p3);
+        CHECK(value.p15.size() == 2 && value.p15[1] == "yy");
+        CHECK(value.p16.size() == 1 && std::get<0>(value.p16[0]) == -1 && std::get<1>(value.p16[0]) == 2.f);
+        CHECK(value.p17.size() == 1 && value.p17[0].at(3) == "c");
+        CHECK(value.p18.size() == 1 && value.p18[0].size() == 1 && value.p18[0].begin()->second == 4);
+    }
+
+    /** fields of test/names.anybuf, named after the identifiers of the generated code */
+    names::names make_names()
+    {
+        names::names value;
+        value.out = "out";
+        value.in = -7;
+        value.count = 3;
+        value.size = 1ull << 40;
+        value.valid = true;
+        value.view = "view";
+        value.skip = 9;
+        value.allocator.emplace_back("allocator");
+        value.other = {-2, "other"};
+        value.table.emplace(5, "table");
+        value.value = names::kind::size;
+        value.data.emplace_back();
+        value.data.back().count = 11;
+        value.fields = 2.5;
+        value.begin.emplace("begin", names::base{});
+        value.begin.begin()->second.in = 12;
+        return value;
+    }
+    void check_names(const names::names &value)
+    {
+        CHECK(value.out == "out" && value.in == -7 && value.count == 3);
+        CHECK(value.size == 1ull << 40 && value.valid && value.view == "view" && value.skip == 9);
+        CHECK(value.allocator.size() == 1 && value.allocator[0] == "allocator");
+        CHECK(std::get<0>(value.other) == -2 && std::get<1>(value.other) == "other");
+        CHECK(value.table.size() == 1 && value.table.at(5) == "table");
+        CHECK(value.value == names::kind::size);
+        CHECK(value.data.size() == 1 && value.data[0].count == 11);
+        CHECK(value.fields == 2.5);
+        CHECK(value.begin.size() == 1 && value.begin.at("begin").in == 12);
+    }
+
+    /** encode, the encoded size, decode, and decode every truncation of the bytes */
+    template <typename T>
+    std::string roundtrip(const T &value, void (*check_value)(const T &))
+    {
+        std::string data;
+        value.encode(data);
+        anybuf_rt::size_sink size;
+        value.encode(size);
+        CHECK(size.size() == data.size());
+
+        T decoded;
+        std::string_view in(data);
+        CHECK(decoded.decode(in) && in.empty());
+        check_value(decoded);
+
+        for (std::size_t length = 0; length < data.size(); ++length)
+        {
+            T truncated;
+            std::string_view part(data.data(), length);
+            CHECK(!truncated.decode(part));
+            CHECK(!anybuf_rt::valid(anybuf_rt::view_t<T>(std::string_view(data.data(), length))));
+        }
+        return data;
+    }
+
+    void test_example()
+    {
+        auto data = roundtrip(make_struct3(), check_struct3);
+
+        example::struct3_view view(data);
+        CHECK(anybuf_rt::valid(view) && anybuf_rt::size(view) == data.size());
+        CHECK(view.p11() == std::string_view("hi"));
+        CHECK(view.p6() == 700);
+        CHECK(static_cast<const example::struct1_view &>(view).p11() == true);
+        CHECK(view.p14() == example::enum1::p3);
+        std::size_t count = 0;
+        if (auto items = view.p15(); items)
+        {
+            for (auto item : *items)
+                count += item.size();
+        }
+        CHECK(count == 3);
+
+        // a bounded struct fits a buffer of its largest encoding
+        example::struct1 bounded;
+        bounded.p8 = UINT64_MAX;
+        bounded.p11 = false;
+        char buffer[example::struct1::max_encoded_size];
+        anybuf_rt::buffer_sink sink(buffer);
+        bounded.encode(sink);
+        std::string encoded;
+        bounded.encode(encoded);
+        CHECK(encoded.size() <= sizeof(buffer) && std::string_view(buffer, encoded.size()) == encoded);
+    }
+    void test_names()
+    {
+        auto data = roundtrip(make_names(), check_names);
+
+        names::names_view view(data);
+        CHECK(anybuf_rt::valid(view) && anybuf_rt::size(view) == data.size());
+        CHECK(view.out() == std::string_view("out") && view.in() == -7 && view.count() == 3u);
+        CHECK(view.size() == 1ull << 40 && view.valid() == true && view.view() == std::string_view("view"));
+        CHECK(view.skip() == 9 && view.value() == names::kind::size && view.fields() == 2.5);
+        auto table = view.table();
+        CHECK(table && table->size() == 1);
+        auto other = view.other();
+        CHECK(other && std::get<1>(*other) == "other");
+        auto items = view.data();
+        CHECK(items && items->size() == 1 && (*items->begin()).count() == 11u);
+    }
+
+#ifdef ANYBUF_TEST_PMR
+    /** the decoded members take their memory from the given resource, never from the default one */
+    void test_pmr()
+    {
+        std::string example, fields;
+        make_struct3().encode(example);
+        make_names().encode(fields);
+
+        std::pmr::monotonic_buffer_resource arena;
+        auto resource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        std::string_view in(example);
+        auto decoded = anybuf_rt::decode<example::struct3>(in, &arena);
+        CHECK(decoded && in.empty() && decoded->get_allocator().resource() == &arena);
+        if (decoded)
+        {
+            check_struct3(*decoded);
+            example::struct3 copy(*decoded, &arena);
+            check_struct3(copy);
+        }
+        in = fields;
+        auto named = anybuf_rt::decode<names::names>(in, &arena);
+        CHECK(named && in.empty());
+        if (named)
+            check_names(*named);
+        std::pmr::set_default_resource(resource);
+    }
+#endif
+} // namespace
+
+int main()
+{
+    test_example();
+    test_names();
+#ifdef ANYBUF_TEST_PMR
+    test_pmr();
+#endif
+    if (failures > 0)
+        std::printf("%d checks failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}